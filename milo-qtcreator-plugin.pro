@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+
+SUBDIRS += plugin \
+    tests
+
+plugin.file = plugin-src/milo.pro
@@ -27,7 +27,16 @@
 
 #include "gitsettings.h"
 
+#include <coreplugin/icore.h>
+#include <coreplugin/iversioncontrol.h>
+#include <coreplugin/vcsmanager.h>
+#include <utils/synchronousprocess.h>
+#include <vcsbase/vcsbaseconstants.h>
+
+#include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
 
 using namespace Utils;
 using namespace VcsBase;
@@ -35,12 +44,152 @@ using namespace VcsBase;
 namespace Git {
 namespace Internal {
 
+// Keep every "git add" command line well below the Windows limit of 32767 characters.
+static const int maxArgumentsLength = 30000;
+
+// --------------------------------------------------------------------
+// GitCommandRunner:
+// --------------------------------------------------------------------
+
+GitCommandRunner::GitCommandRunner(const GitClient *client, const QString &workingDirectory) :
+    VcsBase::VcsCommand(workingDirectory, client->processEnvironment()),
+    m_binary(client->vcsBinary()),
+    m_defaultTimeoutS(client->vcsTimeoutS())
+{
+    // Emitted when the user cancels and when Qt Creator closes.
+    connect(this, &VcsBase::VcsCommand::terminate, this, [this]() { m_canceled.storeRelease(1); },
+            Qt::DirectConnection);
+}
+
+void GitCommandRunner::addGitJob(const QStringList &arguments, int timeoutS)
+{
+    addJob(m_binary, arguments, timeoutS > 0 ? timeoutS : m_defaultTimeoutS);
+    m_stagingJobs.append(false);
+}
+
+// Stages the files with a single "git add". Should git reject them, the files are added one by
+// one to find out which one is to blame, see failedFile().
+void GitCommandRunner::addStagingJob(const QStringList &files, int timeoutS)
+{
+    addJob(m_binary, QStringList({"add", "--"}) + files, timeoutS > 0 ? timeoutS : m_defaultTimeoutS);
+    m_stagingJobs.append(true);
+}
+
+QList<GitCommandRunner::Timing> GitCommandRunner::timings() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timings;
+}
+
+QString GitCommandRunner::failedFile() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failedFile;
+}
+
+QString GitCommandRunner::failedFileError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failedFileError;
+}
+
+// Called from the worker thread for every job, in the order the jobs were added.
+SynchronousProcessResponse GitCommandRunner::runCommand(
+        const FileName &binary, const QStringList &arguments, int timeoutS,
+        const QString &workingDirectory, const ExitCodeInterpreter &interpreter)
+{
+    const int job = m_nextJob++;
+    const bool isStagingJob = job < m_stagingJobs.size() && m_stagingJobs.at(job);
+    if (m_canceled.loadAcquire()) {
+        SynchronousProcessResponse response;
+        response.result = SynchronousProcessResponse::Terminated;
+        return response;
+    }
+
+    SynchronousProcessResponse response
+            = runTimedCommand(binary, arguments, timeoutS, workingDirectory, interpreter);
+    // Only an error exit of git says anything about the files. A canceled, crashed or timed
+    // out "git add" is not retried, so that nothing runs after a cancel.
+    if (!isStagingJob || response.result != SynchronousProcessResponse::FinishedError
+            || m_canceled.loadAcquire()) {
+        return response;
+    }
+
+    const QStringList files = arguments.mid(2);
+    if (files.size() > 1) {
+        for (const QString &file : files) {
+            if (m_canceled.loadAcquire()) {
+                response.result = SynchronousProcessResponse::Terminated;
+                return response;
+            }
+            response = runTimedCommand(binary, {"add", "--", file}, timeoutS, workingDirectory,
+                                       interpreter);
+            if (response.result == SynchronousProcessResponse::FinishedError) {
+                QMutexLocker locker(&m_mutex);
+                m_failedFile = file;
+                m_failedFileError = response.stdErr().trimmed();
+                return response;
+            }
+            if (response.result != SynchronousProcessResponse::Finished)
+                return response;
+        }
+        // Every single file could be added after all.
+        return response;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_failedFile = files.first();
+    m_failedFileError = response.stdErr().trimmed();
+    return response;
+}
+
+SynchronousProcessResponse GitCommandRunner::runTimedCommand(
+        const FileName &binary, const QStringList &arguments, int timeoutS,
+        const QString &workingDirectory, const ExitCodeInterpreter &interpreter)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const SynchronousProcessResponse response
+            = VcsCommand::runCommand(binary, arguments, timeoutS, workingDirectory, interpreter);
+    const bool success = response.result == SynchronousProcessResponse::Finished;
+    const qint64 elapsedMs = timer.elapsed();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_timings.append({arguments, success, elapsedMs});
+    }
+    emit jobFinished(arguments, success, elapsedMs);
+    return response;
+}
+
+// --------------------------------------------------------------------
+// GitClient:
+// --------------------------------------------------------------------
+
 GitClient::GitClient() : VcsBase::VcsBaseClientImpl(new GitSettings),
     m_disableEditor(false)
 {
     m_gitQtcEditor = QString::fromLatin1("\"%1\" -client -block -pid %2")
             .arg(QCoreApplication::applicationFilePath())
             .arg(QCoreApplication::applicationPid());
+
+    connect(Core::VcsManager::instance(), &Core::VcsManager::configurationChanged,
+            this, &GitClient::configurationChanged);
+}
+
+// The git plugin owns the settings page. Pick up its changes and drop what was derived.
+void GitClient::configurationChanged(const Core::IVersionControl *versionControl)
+{
+    if (versionControl && versionControl->id() != Core::Id(VcsBase::Constants::VCS_ID_GIT))
+        return;
+    reloadSettings();
+}
+
+// Reads the git settings again and resolves binary and environment anew the next time.
+void GitClient::reloadSettings()
+{
+    settings().readSettings(Core::ICore::settings());
+    m_binaryResolved = false;
+    m_environmentResolved = false;
 }
 
 VcsBaseEditorWidget *GitClient::annotate(
@@ -58,6 +207,9 @@ VcsBaseEditorWidget *GitClient::annotate(
 
 QProcessEnvironment GitClient::processEnvironment() const
 {
+    if (m_environmentResolved)
+        return m_environment;
+
     QProcessEnvironment environment = VcsBaseClientImpl::processEnvironment();
     QString gitPath = settings().stringValue(GitSettings::pathKey);
     if (!gitPath.isEmpty()) {
@@ -70,16 +222,54 @@ QProcessEnvironment GitClient::processEnvironment() const
         environment.insert("HOME", QDir::toNativeSeparators(QDir::homePath()));
     }
     environment.insert("GIT_EDITOR", m_disableEditor ? "true" : m_gitQtcEditor);
+    m_environment = environment;
+    m_environmentResolved = true;
     return environment;
 }
 
+QList<QStringList> GitClient::chunkedFileArguments(const QString &workingDirectory,
+                                                   const QStringList &files)
+{
+    const QDir workingDir(workingDirectory);
+    QList<QStringList> chunks;
+    QStringList chunk;
+    int chunkLength = 0;
+    for (const QString &file : files) {
+        const QString relativePath = workingDir.relativeFilePath(file);
+        // Account for the separating space and possible quoting.
+        const int length = relativePath.size() + 3;
+        if (!chunk.isEmpty() && chunkLength + length > maxArgumentsLength) {
+            chunks.append(chunk);
+            chunk.clear();
+            chunkLength = 0;
+        }
+        chunk.append(relativePath);
+        chunkLength += length;
+    }
+    if (!chunk.isEmpty())
+        chunks.append(chunk);
+    return chunks;
+}
+
 FileName GitClient::vcsBinary() const
 {
+    if (m_binaryResolved)
+        return m_binary;
+
     bool ok;
     Utils::FileName binary = static_cast<GitSettings &>(settings()).gitExecutable(&ok);
-    if (!ok)
-        return Utils::FileName();
-    return binary;
+    m_binary = ok ? binary : Utils::FileName();
+    m_binaryResolved = true;
+    return m_binary;
+}
+
+GitCommandRunner *GitClient::createCommandRunner(const QString &workingDirectory,
+                                                 const QString &displayName) const
+{
+    auto runner = new GitCommandRunner(this, workingDirectory);
+    if (!displayName.isEmpty())
+        runner->setDisplayName(displayName);
+    return runner;
 }
 
 } // namespace Internal
@@ -26,9 +26,16 @@
 #pragma once
 
 #include <vcsbase/vcsbaseclient.h>
+#include <vcsbase/vcscommand.h>
 
 #include <utils/fileutils.h>
 
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+
+namespace Core { class IVersionControl; }
+
 namespace VcsBase {
     class VcsBaseEditorWidget;
 }
@@ -36,6 +43,55 @@ namespace VcsBase {
 namespace Git {
 namespace Internal {
 
+class GitClient;
+
+// Runs a queue of git invocations back to back in the background and measures each of them.
+class GitCommandRunner : public VcsBase::VcsCommand
+{
+    Q_OBJECT
+
+public:
+    struct Timing
+    {
+        QStringList arguments;
+        bool success;
+        qint64 elapsedMs;
+    };
+
+    GitCommandRunner(const GitClient *client, const QString &workingDirectory);
+
+    void addGitJob(const QStringList &arguments, int timeoutS = -1);
+    void addStagingJob(const QStringList &files, int timeoutS = -1);
+    QList<Timing> timings() const;
+
+    // The file a staging job failed on, and what git had to say about it.
+    QString failedFile() const;
+    QString failedFileError() const;
+
+    Utils::SynchronousProcessResponse runCommand(
+            const Utils::FileName &binary, const QStringList &arguments, int timeoutS,
+            const QString &workingDirectory = QString(),
+            const Utils::ExitCodeInterpreter &interpreter = Utils::defaultExitCodeInterpreter) override;
+
+signals:
+    void jobFinished(const QStringList &arguments, bool success, qint64 elapsedMs);
+
+private:
+    Utils::SynchronousProcessResponse runTimedCommand(
+            const Utils::FileName &binary, const QStringList &arguments, int timeoutS,
+            const QString &workingDirectory, const Utils::ExitCodeInterpreter &interpreter);
+
+    Utils::FileName m_binary;
+    int m_defaultTimeoutS;
+    QVector<bool> m_stagingJobs;    // Per job, whether addStagingJob() added it
+    int m_nextJob = 0;              // Used by the worker thread only
+    QAtomicInt m_canceled;
+    mutable QMutex m_mutex;
+    QList<Timing> m_timings;
+    QString m_failedFile;
+    QString m_failedFileError;
+};
+
 class GitClient : public VcsBase::VcsBaseClientImpl
 {
     Q_OBJECT
@@ -49,9 +105,25 @@ public:
             int lineNumber = -1, const QStringList &extraOptions = QStringList()) override;
     QProcessEnvironment processEnvironment() const override;
 
+    static QList<QStringList> chunkedFileArguments(const QString &workingDirectory,
+                                                   const QStringList &files);
+
+    GitCommandRunner *createCommandRunner(const QString &workingDirectory,
+                                          const QString &displayName = QString()) const;
+
+    void reloadSettings();
+
 private:
+    void configurationChanged(const Core::IVersionControl *versionControl);
+
     QString m_gitQtcEditor;
     bool m_disableEditor;
+
+    // Resolved lazily and kept until the git settings change.
+    mutable bool m_binaryResolved = false;
+    mutable Utils::FileName m_binary;
+    mutable bool m_environmentResolved = false;
+    mutable QProcessEnvironment m_environment;
 };
 
 } // namespace Internal
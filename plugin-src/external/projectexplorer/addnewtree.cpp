@@ -0,0 +1,233 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "addnewtree.h"
+
+#include <projectexplorer/projectexplorer.h>
+
+#include <QCoreApplication>
+
+#include <limits>
+
+namespace ProjectExplorer {
+namespace Internal {
+
+// --------------------------------------------------------------------
+// AddNewTree:
+// --------------------------------------------------------------------
+
+AddNewTree::AddNewTree(const QString &displayName) :
+    m_displayName(displayName)
+{ }
+
+// FIXME: potentially merge the following two functions.
+// Note the different handling of 'node' and m_canAdd.
+AddNewTree::AddNewTree(FolderNode *node, QList<AddNewTree *> children, const QString &displayName) :
+    m_displayName(displayName),
+    m_node(node),
+    m_canAdd(false)
+{
+    if (node)
+        m_directory = ProjectExplorerPlugin::directoryFor(node);
+    foreach (AddNewTree *child, children)
+        appendChild(child);
+}
+
+AddNewTree::AddNewTree(FolderNode *node, QList<AddNewTree *> children,
+                       const FolderNode::AddNewInformation &info) :
+    m_displayName(info.displayName),
+    m_node(node),
+    m_priority(info.priority)
+{
+    if (node)
+        m_directory = ProjectExplorerPlugin::directoryFor(node);
+    foreach (AddNewTree *child, children)
+        appendChild(child);
+}
+
+
+QVariant AddNewTree::data(int, int role) const
+{
+    switch (role) {
+    case Qt::DisplayRole:
+        return m_displayName;
+    case Qt::ToolTipRole:
+        return m_directory;
+    case Qt::UserRole:
+        return QVariant::fromValue(static_cast<void*>(node()));
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags AddNewTree::flags(int) const
+{
+    if (m_canAdd)
+        return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+    return Qt::NoItemFlags;
+}
+
+// --------------------------------------------------------------------
+// BestNodeSelector:
+// --------------------------------------------------------------------
+
+BestNodeSelector::BestNodeSelector(const QString &commonDirectory, const QStringList &files) :
+    m_commonDirectory(commonDirectory),
+    m_files(files),
+    m_deployText(QCoreApplication::translate("ProjectWizard", "The files are implicitly added to the projects:") + QLatin1Char('\n'))
+{
+    // Index the common directory and all of its parents, so that checking whether a project
+    // directory contains the new files is a single lookup instead of a string scan per node.
+    QString prefix = m_commonDirectory;
+    while (true) {
+        m_commonDirectoryPrefixes.insert(prefix);
+        const int slash = prefix.lastIndexOf(QLatin1Char('/'));
+        if (slash < 0)
+            break;
+        prefix.truncate(slash);
+    }
+}
+
+// Find the project the new files should be added
+// If any node deploys the files, then we don't want to add the files.
+// Otherwise consider their common path. Either a direct match on the directory
+// or the directory with the longest matching path (list containing"/project/subproject1"
+// matching common path "/project/subproject1/newuserpath").
+void BestNodeSelector::inspect(AddNewTree *tree, bool isContextNode)
+{
+    FolderNode *node = tree->node();
+    if (node->nodeType() == NodeType::Project) {
+        if (static_cast<ProjectNode *>(node)->deploysFolder(m_commonDirectory)) {
+            m_deploys = true;
+            m_deployText += tree->displayName() + QLatin1Char('\n');
+        }
+    }
+    if (m_deploys)
+        return;
+
+    const int projectDirectorySize = tree->directory().size();
+    if (!isContextNode && !m_commonDirectoryPrefixes.contains(tree->directory()))
+        return;
+
+    bool betterMatch = isContextNode
+            || (tree->priority() > 0
+                && (projectDirectorySize > m_bestMatchLength
+                    || (projectDirectorySize == m_bestMatchLength && tree->priority() > m_bestMatchPriority)));
+
+    if (betterMatch) {
+        m_bestMatchPriority = tree->priority();
+        m_bestMatchLength = isContextNode ? std::numeric_limits<int>::max() : projectDirectorySize;
+        m_bestChoice = tree;
+    }
+}
+
+AddNewTree *BestNodeSelector::bestChoice() const
+{
+    if (m_deploys)
+        return 0;
+    return m_bestChoice;
+}
+
+bool BestNodeSelector::deploys()
+{
+    return m_deploys;
+}
+
+QString BestNodeSelector::deployingProjects() const
+{
+    if (m_deploys)
+        return m_deployText;
+    return QString();
+}
+
+// --------------------------------------------------------------------
+// Helper:
+// --------------------------------------------------------------------
+
+AddNewTree *createNoneNode(BestNodeSelector *selector)
+{
+    QString displayName = QCoreApplication::translate("ProjectWizard", "<None>");
+    if (selector->deploys())
+        displayName = QCoreApplication::translate("ProjectWizard", "<Implicitly Add>");
+    return new AddNewTree(displayName);
+}
+
+AddNewTree *buildAddProjectTree(ProjectNode *root, const QString &projectPath, Node *contextNode, BestNodeSelector *selector)
+{
+    QList<AddNewTree *> children;
+    for (Node *node : root->nodes()) {
+        if (ProjectNode *pn = node->asProjectNode()) {
+            if (AddNewTree *child = buildAddProjectTree(pn, projectPath, contextNode, selector))
+                children.append(child);
+        }
+    }
+
+    if (root->supportsAction(AddSubProject, root) && !root->supportsAction(InheritedFromParent, root)) {
+        if (projectPath.isEmpty() || root->canAddSubProject(projectPath)) {
+            FolderNode::AddNewInformation info = root->addNewInformation(QStringList() << projectPath, contextNode);
+            auto item = new AddNewTree(root, children, info);
+            selector->inspect(item, root == contextNode);
+            return item;
+        }
+    }
+
+    if (children.isEmpty())
+        return nullptr;
+    return new AddNewTree(root, children, root->displayName());
+}
+
+AddNewTree *buildAddFilesTree(FolderNode *root, const QStringList &files,
+                             Node *contextNode, BestNodeSelector *selector)
+{
+    QList<AddNewTree *> children;
+    foreach (FolderNode *fn, root->folderNodes()) {
+        AddNewTree *child = buildAddFilesTree(fn, files, contextNode, selector);
+        if (child)
+            children.append(child);
+    }
+
+    if (root->supportsAction(AddNewFile, root) && !root->supportsAction(InheritedFromParent, root)) {
+        FolderNode::AddNewInformation info = root->addNewInformation(files, contextNode);
+        auto item = new AddNewTree(root, children, info);
+        selector->inspect(item, root == contextNode);
+        return item;
+    }
+    if (children.isEmpty())
+        return nullptr;
+    return new AddNewTree(root, children, root->displayName());
+}
+
+// Feeds an already built subtree to the selector in the same order buildAddFilesTree
+// and buildAddProjectTree inspect freshly created items.
+void inspectAddNewTree(AddNewTree *tree, Node *contextNode, BestNodeSelector *selector)
+{
+    for (int i = 0, count = tree->childCount(); i < count; ++i)
+        inspectAddNewTree(static_cast<AddNewTree *>(tree->childAt(i)), contextNode, selector);
+    if (tree->canAdd())
+        selector->inspect(tree, tree->node() == contextNode);
+}
+
+} // namespace Internal
+} // namespace ProjectExplorer
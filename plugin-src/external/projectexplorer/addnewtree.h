@@ -0,0 +1,92 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <projectexplorer/projectnodes.h>
+
+#include <utils/treemodel.h>
+
+#include <QSet>
+#include <QStringList>
+
+namespace ProjectExplorer {
+namespace Internal {
+
+// An item of the "Add to project" tree of the ProjectWizardPage.
+class AddNewTree : public Utils::TreeItem
+{
+public:
+    AddNewTree(const QString &displayName);
+    AddNewTree(FolderNode *node, QList<AddNewTree *> children, const QString &displayName);
+    AddNewTree(FolderNode *node, QList<AddNewTree *> children, const FolderNode::AddNewInformation &info);
+
+    QVariant data(int column, int role) const;
+    Qt::ItemFlags flags(int column) const;
+
+    QString displayName() const { return m_displayName; }
+    QString directory() const { return m_directory; }
+    FolderNode *node() const { return m_node; }
+    int priority() const { return m_priority; }
+    bool canAdd() const { return m_canAdd; }
+
+private:
+    QString m_displayName;
+    QString m_directory;
+    FolderNode *m_node = nullptr;
+    bool m_canAdd = true;
+    int m_priority = -1;
+};
+
+// Picks the item the new files are most likely meant to be added to.
+class BestNodeSelector
+{
+public:
+    BestNodeSelector(const QString &commonDirectory, const QStringList &files);
+    void inspect(AddNewTree *tree, bool isContextNode);
+    AddNewTree *bestChoice() const;
+    bool deploys();
+    QString deployingProjects() const;
+
+private:
+    QString m_commonDirectory;
+    QSet<QString> m_commonDirectoryPrefixes;
+    QStringList m_files;
+    bool m_deploys = false;
+    QString m_deployText;
+    AddNewTree *m_bestChoice = nullptr;
+    int m_bestMatchLength = -1;
+    int m_bestMatchPriority = -1;
+};
+
+AddNewTree *createNoneNode(BestNodeSelector *selector);
+AddNewTree *buildAddProjectTree(ProjectNode *root, const QString &projectPath, Node *contextNode,
+                                BestNodeSelector *selector);
+AddNewTree *buildAddFilesTree(FolderNode *root, const QStringList &files, Node *contextNode,
+                              BestNodeSelector *selector);
+void inspectAddNewTree(AddNewTree *tree, Node *contextNode, BestNodeSelector *selector);
+
+} // namespace Internal
+} // namespace ProjectExplorer
@@ -25,6 +25,8 @@
 
 #include "jsonsummarypage.h"
 
+#include "milologging.h"
+
 //#include "jsonwizard.h"
 #include <projectexplorer/project.h>
 #include <projectexplorer/projectexplorerconstants.h>
@@ -38,10 +40,14 @@
 #include <utils/algorithm.h>
 #include <utils/qtcassert.h>
 
+#include <vcsbase/vcsoutputwindow.h>
+
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMessageBox>
 
 using namespace Core;
+using namespace Milo::Internal;
 
 static char KEY_SELECTED_PROJECT[] = "SelectedProject";
 static char KEY_SELECTED_NODE[] = "SelectedFolderNode";
@@ -81,6 +87,10 @@ static IWizardFactory::WizardKind wizardKind(JsonWizard *wiz)
 
 static const char KEY_HIDE_PROJECT_UI[] = "hideProjectUi";
 
+// Every project or version control combo box change regenerates the file list, and
+// users tend to toggle between a few choices only.
+static const int MAX_FILE_LIST_CACHE_SIZE = 8;
+
 SummaryPageFactory::SummaryPageFactory()
 {
     setTypeIdsSuffix(QLatin1String("MiloSummary"));
@@ -118,6 +128,9 @@ JsonSummaryPage::JsonSummaryPage(QWidget *parent) :
     Internal::ProjectWizardPage(parent),
     m_wizard(nullptr)
 {
+    m_projectTreeUpdateTimer.setSingleShot(true);
+    m_projectTreeUpdateTimer.setInterval(100);
+
     connect(this, &Internal::ProjectWizardPage::projectNodeChanged,
             this, &JsonSummaryPage::summarySettingsHaveChanged);
     connect(this, &Internal::ProjectWizardPage::versionControlChanged,
@@ -168,11 +181,18 @@ void JsonSummaryPage::initializePage()
 
     initializeProjectTree(contextNode, files, kind, currentAction);
 
-    // Refresh combobox on project tree changes:
-    connect(ProjectTree::instance(), &ProjectTree::treeChanged,
+    // Refresh combobox on project tree changes. Projects that are still parsing emit
+    // treeChanged in bursts, so coalesce them into a single update. The context stays the
+    // wizard's, the page keeps whatever the user selected on its own:
+    disconnect(&m_projectTreeUpdateTimer, &QTimer::timeout, this, nullptr);
+    connect(&m_projectTreeUpdateTimer, &QTimer::timeout,
             this, [this, files, kind, currentAction]() {
-        initializeProjectTree(findWizardContextNode(currentNode()), files, kind, currentAction);
+        auto contextNode = findWizardContextNode(static_cast<Node *>(m_wizard->value(Constants::PREFERRED_PROJECT_NODE).value<void *>()));
+        initializeProjectTree(contextNode, files, kind, currentAction);
     });
+    connect(ProjectTree::instance(), &ProjectTree::treeChanged,
+            &m_projectTreeUpdateTimer, static_cast<void (QTimer::*)()>(&QTimer::start),
+            Qt::UniqueConnection);
 
 
     bool hideProjectUi = JsonWizard::boolFromVariant(m_hideProjectUiValue, m_wizard->expander());
@@ -188,12 +208,14 @@ bool JsonSummaryPage::validatePage()
 {
     m_wizard->commitToFileList(m_fileList);
     m_fileList.clear();
+    m_fileListCache.clear();
     return true;
 }
 
 void JsonSummaryPage::cleanupPage()
 {
     disconnect(m_wizard, &JsonWizard::filesReady, this, nullptr);
+    m_fileListCache.clear();
 }
 
 void JsonSummaryPage::triggerCommit(const JsonWizard::GeneratorFiles &files)
@@ -202,11 +224,17 @@ void JsonSummaryPage::triggerCommit(const JsonWizard::GeneratorFiles &files)
             = Utils::transform(files, [](const JsonWizard::GeneratorFile &f) -> GeneratedFile
                                       { return f.file; });
 
+    // Git operations continue in the background, so the wizard can close right away.
+    // Failures are reported in the Version Control output pane instead of a modal dialog.
+    QElapsedTimer timer;
+    timer.start();
     QString errorMessage;
-    if (!runVersionControl(coreFiles, &errorMessage)) {
-        QMessageBox::critical(wizard(), tr("Failed to Commit to Version Control"),
-                              tr("Error message from Version Control System: \"%1\".")
-                              .arg(errorMessage));
+    const bool ok = runVersionControl(coreFiles, &errorMessage);
+    qCDebug(versionControlLog) << "Started version control for" << coreFiles.size() << "files in"
+                               << timer.elapsed() << "ms";
+    if (!ok) {
+        VcsBase::VcsOutputWindow::appendError(
+                    tr("Failed to commit to version control: \"%1\".").arg(errorMessage));
     }
 }
 
@@ -269,9 +297,40 @@ Node *JsonSummaryPage::findWizardContextNode(Node *contextNode) const
     return contextNode;
 }
 
+// Expanding the templates is expensive, so the result is cached. The wizard's variables are
+// everything the expander gets to see from the wizard, so the template is only expanded again
+// when one of them differs from a previous expansion.
+JsonWizard::GeneratorFiles JsonSummaryPage::generateFileList()
+{
+    const QHash<QString, QVariant> variables = m_wizard->variables();
+    for (int i = 0; i < m_fileListCache.count(); ++i) {
+        if (m_fileListCache.at(i).variables == variables) {
+            ++m_fileListCacheHits;
+            qCDebug(fileListLog) << "File list cache hit," << m_fileListCacheHits << "hits,"
+                                 << m_fileListCacheMisses << "misses";
+            m_fileListCache.move(i, 0);
+            return m_fileListCache.first().files;
+        }
+    }
+
+    ++m_fileListCacheMisses;
+    QElapsedTimer timer;
+    timer.start();
+    const JsonWizard::GeneratorFiles files = m_wizard->generateFileList();
+    qCDebug(fileListLog) << "Generated" << files.size() << "files in" << timer.elapsed() << "ms,"
+                         << m_fileListCacheHits << "hits," << m_fileListCacheMisses << "misses";
+    if (files.isEmpty()) // Generation failed, try again next time.
+        return files;
+
+    m_fileListCache.prepend({variables, files});
+    if (m_fileListCache.count() > MAX_FILE_LIST_CACHE_SIZE)
+        m_fileListCache.removeLast();
+    return files;
+}
+
 void JsonSummaryPage::updateFileList()
 {
-    m_fileList = m_wizard->generateFileList();
+    m_fileList = generateFileList();
     QStringList filePaths
             = Utils::transform(m_fileList, [](const JsonWizard::GeneratorFile &f) { return f.file.path(); });
     setFiles(filePaths);
@@ -30,6 +30,7 @@
 #include <projectexplorer/jsonwizard/jsonwizard.h>
 #include <projectexplorer/jsonwizard/jsonwizardpagefactory.h>
 
+#include <QTimer>
 #include <QWizardPage>
 
 namespace ProjectExplorer {
@@ -63,14 +64,28 @@ public:
     void addToProject(const JsonWizard::GeneratorFiles &files);
     void summarySettingsHaveChanged();
 
+    int fileListCacheHits() const { return m_fileListCacheHits; }
+    int fileListCacheMisses() const { return m_fileListCacheMisses; }
+
 private:
+    struct FileListCacheEntry
+    {
+        QHash<QString, QVariant> variables;
+        JsonWizard::GeneratorFiles files;
+    };
+
     Node *findWizardContextNode(Node *contextNode) const;
+    JsonWizard::GeneratorFiles generateFileList();
     void updateFileList();
     void updateProjectData(FolderNode *node);
 
     JsonWizard *m_wizard;
     JsonWizard::GeneratorFiles m_fileList;
     QVariant m_hideProjectUiValue;
+    QTimer m_projectTreeUpdateTimer;
+    QList<FileListCacheEntry> m_fileListCache;
+    int m_fileListCacheHits = 0;
+    int m_fileListCacheMisses = 0;
 };
 
 } // namespace ProjectExplorer
@@ -24,14 +24,20 @@
 ****************************************************************************/
 
 #include "projectwizardpage.h"
+#include "addnewtree.h"
 #include "ui_projectwizardpage.h"
 
 #include "gitclient.h"
 
+#include "miloconstants.h"
+#include "milogitpipeline.h"
+#include "miloinitialcommitwriter.h"
+#include "milologging.h"
 #include "miloplugin.h"
 
 #include <projectexplorer/project.h>
 #include <projectexplorer/projectexplorer.h>
+#include <projectexplorer/projecttree.h>
 #include <projectexplorer/session.h>
 
 #include <coreplugin/icore.h>
@@ -40,17 +46,26 @@
 #include <coreplugin/vcsmanager.h>
 #include <utils/algorithm.h>
 #include <utils/fileutils.h>
+#include <utils/hostosinfo.h>
 #include <utils/qtcassert.h>
 #include <utils/stringutils.h>
 #include <utils/treemodel.h>
+#include <utils/treeviewcombobox.h>
 #include <utils/wizard.h>
 #include <vcsbase/vcsbaseconstants.h>
-#include <vcsbase/vcscommand.h>
+#include <vcsbase/vcsoutputwindow.h>
 
+#include <QAbstractItemModel>
 #include <QDir>
-#include <QTextStream>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QSettings>
+#include <QSharedPointer>
 #include <QTreeView>
 
+#include <algorithm>
+#include <numeric>
+
 /*!
     \class ProjectExplorer::Internal::ProjectWizardPage
 
@@ -61,224 +76,163 @@
 */
 
 using namespace Core;
+using namespace Git::Internal;
 using namespace Milo::Internal;
 using namespace Utils;
 
 namespace ProjectExplorer {
 namespace Internal {
 
-class AddNewTree : public TreeItem
+// --------------------------------------------------------------------
+// GeneratedFilesModel:
+// --------------------------------------------------------------------
+
+// Lists the files to be added, either flat or grouped by their directory. Sort keys are
+// computed once per file list, display strings only for the rows the view asks for.
+class GeneratedFilesModel : public QAbstractItemModel
 {
 public:
-    AddNewTree(const QString &displayName);
-    AddNewTree(FolderNode *node, QList<AddNewTree *> children, const QString &displayName);
-    AddNewTree(FolderNode *node, QList<AddNewTree *> children, const FolderNode::AddNewInformation &info);
+    explicit GeneratedFilesModel(QObject *parent = nullptr) : QAbstractItemModel(parent) { }
 
-    QVariant data(int column, int role) const;
-    Qt::ItemFlags flags(int column) const;
+    void setFiles(const QStringList &relativeFilePaths);
+    void setGroupByDirectory(bool group);
 
-    QString displayName() const { return m_displayName; }
-    FolderNode *node() const { return m_node; }
-    int priority() const { return m_priority; }
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
 private:
-    QString m_displayName;
-    QString m_toolTip;
-    FolderNode *m_node = nullptr;
-    bool m_canAdd = true;
-    int m_priority = -1;
-};
+    struct Entry
+    {
+        QString path;
+        QString directory;
+        QString fileName;
+    };
 
-AddNewTree::AddNewTree(const QString &displayName) :
-    m_displayName(displayName)
-{ }
+    struct Group
+    {
+        QString directory;
+        int first;
+        int count;
+    };
 
-// FIXME: potentially merge the following two functions.
-// Note the different handling of 'node' and m_canAdd.
-AddNewTree::AddNewTree(FolderNode *node, QList<AddNewTree *> children, const QString &displayName) :
-    m_displayName(displayName),
-    m_node(node),
-    m_canAdd(false)
-{
-    if (node)
-        m_toolTip = ProjectExplorerPlugin::directoryFor(node);
-    foreach (AddNewTree *child, children)
-        appendChild(child);
-}
+    QVector<Entry> m_entries;       // Files in sub-directories first, then alphabetically
+    QVector<int> m_groupedEntries;  // Indices into m_entries, ordered by directory
+    QVector<Group> m_groups;
+    bool m_groupByDirectory = false;
+};
 
-AddNewTree::AddNewTree(FolderNode *node, QList<AddNewTree *> children,
-                       const FolderNode::AddNewInformation &info) :
-    m_displayName(info.displayName),
-    m_node(node),
-    m_priority(info.priority)
+void GeneratedFilesModel::setFiles(const QStringList &relativeFilePaths)
 {
-    if (node)
-        m_toolTip = ProjectExplorerPlugin::directoryFor(node);
-    foreach (AddNewTree *child, children)
-        appendChild(child);
-}
+    beginResetModel();
 
+    m_entries.clear();
+    m_entries.reserve(relativeFilePaths.size());
+    for (const QString &path : relativeFilePaths) {
+        const int slash = path.lastIndexOf(QLatin1Char('/'));
+        m_entries.append({path, slash < 0 ? QString() : path.left(slash), path.mid(slash + 1)});
+    }
 
-QVariant AddNewTree::data(int, int role) const
-{
-    switch (role) {
-    case Qt::DisplayRole:
-        return m_displayName;
-    case Qt::ToolTipRole:
-        return m_toolTip;
-    case Qt::UserRole:
-        return QVariant::fromValue(static_cast<void*>(node()));
-    default:
-        return QVariant();
+    const Qt::CaseSensitivity cs = HostOsInfo::fileNameCaseSensitivity();
+    std::stable_sort(m_entries.begin(), m_entries.end(), [cs](const Entry &e1, const Entry &e2) {
+        const bool e1HasDir = !e1.directory.isEmpty();
+        const bool e2HasDir = !e2.directory.isEmpty();
+        if (e1HasDir == e2HasDir)
+            return QString::compare(e1.path, e2.path, cs) < 0;
+        return e1HasDir;
+    });
+
+    m_groupedEntries.resize(m_entries.size());
+    std::iota(m_groupedEntries.begin(), m_groupedEntries.end(), 0);
+    std::stable_sort(m_groupedEntries.begin(), m_groupedEntries.end(), [this, cs](int i1, int i2) {
+        const Entry &e1 = m_entries.at(i1);
+        const Entry &e2 = m_entries.at(i2);
+        if (e1.directory.isEmpty() != e2.directory.isEmpty())
+            return e2.directory.isEmpty();
+        const int result = QString::compare(e1.directory, e2.directory, cs);
+        if (result != 0)
+            return result < 0;
+        return QString::compare(e1.fileName, e2.fileName, cs) < 0;
+    });
+
+    m_groups.clear();
+    for (int i = 0; i < m_groupedEntries.size(); ++i) {
+        const QString &directory = m_entries.at(m_groupedEntries.at(i)).directory;
+        if (m_groups.isEmpty() || m_groups.last().directory != directory)
+            m_groups.append({directory, i, 0});
+        ++m_groups.last().count;
     }
-}
 
-Qt::ItemFlags AddNewTree::flags(int) const
-{
-    if (m_canAdd)
-        return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
-    return Qt::NoItemFlags;
+    endResetModel();
 }
 
-// --------------------------------------------------------------------
-// BestNodeSelector:
-// --------------------------------------------------------------------
-
-class BestNodeSelector
+void GeneratedFilesModel::setGroupByDirectory(bool group)
 {
-public:
-    BestNodeSelector(const QString &commonDirectory, const QStringList &files);
-    void inspect(AddNewTree *tree, bool isContextNode);
-    AddNewTree *bestChoice() const;
-    bool deploys();
-    QString deployingProjects() const;
-
-private:
-    QString m_commonDirectory;
-    QStringList m_files;
-    bool m_deploys = false;
-    QString m_deployText;
-    AddNewTree *m_bestChoice = nullptr;
-    int m_bestMatchLength = -1;
-    int m_bestMatchPriority = -1;
-};
-
-BestNodeSelector::BestNodeSelector(const QString &commonDirectory, const QStringList &files) :
-    m_commonDirectory(commonDirectory),
-    m_files(files),
-    m_deployText(QCoreApplication::translate("ProjectWizard", "The files are implicitly added to the projects:") + QLatin1Char('\n'))
-{ }
-
-// Find the project the new files should be added
-// If any node deploys the files, then we don't want to add the files.
-// Otherwise consider their common path. Either a direct match on the directory
-// or the directory with the longest matching path (list containing"/project/subproject1"
-// matching common path "/project/subproject1/newuserpath").
-void BestNodeSelector::inspect(AddNewTree *tree, bool isContextNode)
-{
-    FolderNode *node = tree->node();
-    if (node->nodeType() == NodeType::Project) {
-        if (static_cast<ProjectNode *>(node)->deploysFolder(m_commonDirectory)) {
-            m_deploys = true;
-            m_deployText += tree->displayName() + QLatin1Char('\n');
-        }
-    }
-    if (m_deploys)
-        return;
-
-    const QString projectDirectory = ProjectExplorerPlugin::directoryFor(node);
-    const int projectDirectorySize = projectDirectory.size();
-    if (m_commonDirectory != projectDirectory
-            && !m_commonDirectory.startsWith(projectDirectory + QLatin1Char('/'))
-            && !isContextNode)
+    if (group == m_groupByDirectory)
         return;
-
-    bool betterMatch = isContextNode
-            || (tree->priority() > 0
-                && (projectDirectorySize > m_bestMatchLength
-                    || (projectDirectorySize == m_bestMatchLength && tree->priority() > m_bestMatchPriority)));
-
-    if (betterMatch) {
-        m_bestMatchPriority = tree->priority();
-        m_bestMatchLength = isContextNode ? std::numeric_limits<int>::max() : projectDirectorySize;
-        m_bestChoice = tree;
-    }
+    beginResetModel();
+    m_groupByDirectory = group;
+    endResetModel();
 }
 
-AddNewTree *BestNodeSelector::bestChoice() const
+// Group rows have an internal id of 0, file rows inside a group the group's row plus one.
+QModelIndex GeneratedFilesModel::index(int row, int column, const QModelIndex &parent) const
 {
-    if (m_deploys)
-        return 0;
-    return m_bestChoice;
+    if (!hasIndex(row, column, parent))
+        return QModelIndex();
+    return createIndex(row, column, parent.isValid() ? quintptr(parent.row() + 1) : quintptr(0));
 }
 
-bool BestNodeSelector::deploys()
+QModelIndex GeneratedFilesModel::parent(const QModelIndex &child) const
 {
-    return m_deploys;
+    if (!child.isValid() || child.internalId() == 0)
+        return QModelIndex();
+    return createIndex(int(child.internalId() - 1), 0, quintptr(0));
 }
 
-QString BestNodeSelector::deployingProjects() const
+int GeneratedFilesModel::rowCount(const QModelIndex &parent) const
 {
-    if (m_deploys)
-        return m_deployText;
-    return QString();
+    if (!parent.isValid())
+        return m_groupByDirectory ? m_groups.size() : m_entries.size();
+    if (m_groupByDirectory && parent.internalId() == 0 && parent.column() == 0)
+        return m_groups.at(parent.row()).count;
+    return 0;
 }
 
-// --------------------------------------------------------------------
-// Helper:
-// --------------------------------------------------------------------
-
-static inline AddNewTree *createNoneNode(BestNodeSelector *selector)
+int GeneratedFilesModel::columnCount(const QModelIndex &parent) const
 {
-    QString displayName = QCoreApplication::translate("ProjectWizard", "<None>");
-    if (selector->deploys())
-        displayName = QCoreApplication::translate("ProjectWizard", "<Implicitly Add>");
-    return new AddNewTree(displayName);
+    Q_UNUSED(parent)
+    return 1;
 }
 
-static inline AddNewTree *buildAddProjectTree(ProjectNode *root, const QString &projectPath, Node *contextNode, BestNodeSelector *selector)
+QVariant GeneratedFilesModel::data(const QModelIndex &index, int role) const
 {
-    QList<AddNewTree *> children;
-    for (Node *node : root->nodes()) {
-        if (ProjectNode *pn = node->asProjectNode()) {
-            if (AddNewTree *child = buildAddProjectTree(pn, projectPath, contextNode, selector))
-                children.append(child);
-        }
-    }
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
 
-    if (root->supportsAction(AddSubProject, root) && !root->supportsAction(InheritedFromParent, root)) {
-        if (projectPath.isEmpty() || root->canAddSubProject(projectPath)) {
-            FolderNode::AddNewInformation info = root->addNewInformation(QStringList() << projectPath, contextNode);
-            auto item = new AddNewTree(root, children, info);
-            selector->inspect(item, root == contextNode);
-            return item;
-        }
-    }
+    if (!m_groupByDirectory)
+        return QDir::toNativeSeparators(m_entries.at(index.row()).path);
 
-    if (children.isEmpty())
-        return nullptr;
-    return new AddNewTree(root, children, root->displayName());
+    if (index.internalId() == 0) {
+        const QString &directory = m_groups.at(index.row()).directory;
+        return directory.isEmpty() ? QString(QLatin1Char('.')) : QDir::toNativeSeparators(directory);
+    }
+    const Group &group = m_groups.at(int(index.internalId() - 1));
+    return m_entries.at(m_groupedEntries.at(group.first + index.row())).fileName;
 }
 
-static inline AddNewTree *buildAddFilesTree(FolderNode *root, const QStringList &files,
-                                            Node *contextNode, BestNodeSelector *selector)
-{
-    QList<AddNewTree *> children;
-    foreach (FolderNode *fn, root->folderNodes()) {
-        AddNewTree *child = buildAddFilesTree(fn, files, contextNode, selector);
-        if (child)
-            children.append(child);
-    }
+// --------------------------------------------------------------------
+// Helper:
+// --------------------------------------------------------------------
 
-    if (root->supportsAction(AddNewFile, root) && !root->supportsAction(InheritedFromParent, root)) {
-        FolderNode::AddNewInformation info = root->addNewInformation(files, contextNode);
-        auto item = new AddNewTree(root, children, info);
-        selector->inspect(item, root == contextNode);
-        return item;
-    }
-    if (children.isEmpty())
-        return nullptr;
-    return new AddNewTree(root, children, root->displayName());
+// Identifies an item among its siblings. The keys of the items on the path from the root
+// identify it in the tree. Unlike the node pointer, the key can be computed after the node was
+// deleted, and it does not match a new node that happens to get the deleted node's address.
+static QString itemKey(const AddNewTree *item)
+{
+    return item->displayName() + QLatin1Char('\t') + item->directory() + QLatin1Char('\n');
 }
 
 // --------------------------------------------------------------------
@@ -286,9 +240,11 @@ static inline AddNewTree *buildAddFilesTree(FolderNode *root, const QStringList
 // --------------------------------------------------------------------
 
 ProjectWizardPage::ProjectWizardPage(QWidget *parent) : WizardPage(parent),
-    m_ui(new Ui::WizardPage)
+    m_ui(new Ui::WizardPage),
+    m_filesModel(new GeneratedFilesModel(this))
 {
     m_ui->setupUi(this);
+    m_ui->filesView->setModel(m_filesModel);
     m_ui->vcsManageButton->setText(ICore::msgShowOptionsDialog());
     connect(m_ui->projectComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
             this, &ProjectWizardPage::projectChanged);
@@ -299,10 +255,13 @@ ProjectWizardPage::ProjectWizardPage(QWidget *parent) : WizardPage(parent),
     connect(m_ui->initialCommitCheckBox, &QCheckBox::toggled, this, &ProjectWizardPage::updateGitRepositoryUiElements);
     connect(m_ui->gitRepoLineEdit, &QLineEdit::textChanged, this, &ProjectWizardPage::updatePushToRemoteUiElements);
     connect(m_ui->vcsManageButton, &QAbstractButton::clicked, this, &ProjectWizardPage::manageVcs);
+    connect(m_ui->groupByDirectoryCheckBox, &QCheckBox::toggled, this, &ProjectWizardPage::groupFilesByDirectory);
     setProperty(SHORT_TITLE_PROPERTY, tr("Summary"));
 
     connect(VcsManager::instance(), &VcsManager::configurationChanged,
             this, &ProjectExplorer::Internal::ProjectWizardPage::initializeVersionControls);
+    connect(ProjectTree::instance(), &ProjectTree::subtreeChanged,
+            this, &ProjectWizardPage::projectSubtreeChanged);
 
     m_ui->projectComboBox->setModel(&m_model);
 }
@@ -352,6 +311,61 @@ void ProjectWizardPage::setBestNode(AddNewTree *tree)
     }
 }
 
+// Collects the keys of the expanded items below parent, without descending into collapsed ones.
+void ProjectWizardPage::saveExpandedItems(const QModelIndex &parent, const QString &parentKey,
+                                          QSet<QString> *expandedKeys) const
+{
+    TreeViewComboBoxView *view = m_ui->projectComboBox->view();
+    for (int row = 0, rows = m_model.rowCount(parent); row < rows; ++row) {
+        const QModelIndex index = m_model.index(row, 0, parent);
+        if (!view->isExpanded(index))
+            continue;
+        const QString key = parentKey + itemKey(static_cast<AddNewTree *>(m_model.itemForIndex(index)));
+        expandedKeys->insert(key);
+        saveExpandedItems(index, key, expandedKeys);
+    }
+}
+
+void ProjectWizardPage::restoreExpandedItems(const QModelIndex &parent, const QString &parentKey,
+                                             const QSet<QString> &expandedKeys)
+{
+    TreeViewComboBoxView *view = m_ui->projectComboBox->view();
+    for (int row = 0, rows = m_model.rowCount(parent); row < rows; ++row) {
+        const QModelIndex index = m_model.index(row, 0, parent);
+        const QString key = parentKey + itemKey(static_cast<AddNewTree *>(m_model.itemForIndex(index)));
+        if (expandedKeys.contains(key)) {
+            view->expand(index);
+            restoreExpandedItems(index, key, expandedKeys);
+        }
+    }
+}
+
+// The item keys from the top level down to the item at index.
+QStringList ProjectWizardPage::itemPath(const QModelIndex &index) const
+{
+    QStringList path;
+    for (QModelIndex i = index; i.isValid(); i = i.parent())
+        path.prepend(itemKey(static_cast<AddNewTree *>(m_model.itemForIndex(i))));
+    return path;
+}
+
+QModelIndex ProjectWizardPage::indexForItemPath(const QStringList &path) const
+{
+    QModelIndex parent;
+    for (const QString &key : path) {
+        QModelIndex match;
+        for (int row = 0, rows = m_model.rowCount(parent); row < rows && !match.isValid(); ++row) {
+            const QModelIndex index = m_model.index(row, 0, parent);
+            if (itemKey(static_cast<AddNewTree *>(m_model.itemForIndex(index))) == key)
+                match = index;
+        }
+        if (!match.isValid())
+            return QModelIndex();
+        parent = match;
+    }
+    return parent;
+}
+
 FolderNode *ProjectWizardPage::currentNode() const
 {
     QVariant v = m_ui->projectComboBox->currentData(Qt::UserRole);
@@ -425,6 +439,16 @@ bool ProjectWizardPage::runVersionControl(const QList<GeneratedFile> &files, QSt
     QTC_ASSERT(!m_commonDirectory.isEmpty(), return false);
 
     IVersionControl *versionControl = m_activeVersionControls.at(vcsIndex);
+    if (versionControl->id() == Core::Id(VcsBase::Constants::VCS_ID_GIT)) {
+        // Only the git steps need the GitClient, other version control systems work without it.
+        if (!MiloPlugin::gitClient()) {
+            *errorMessage = tr("GitClient object is not valid.");
+            return false;
+        }
+        startGitPipeline(files);
+        return true;
+    }
+
     // Create repository?
     if (!m_repositoryExists) {
         QTC_ASSERT(versionControl->supportsOperation(IVersionControl::CreateRepositoryOperation), return false);
@@ -442,87 +466,181 @@ bool ProjectWizardPage::runVersionControl(const QList<GeneratedFile> &files, QSt
             }
         }
     }
+    return true;
+}
 
-    // Starting point for custom operations
-    auto git = MiloPlugin::gitClient();
-    if (git == nullptr) {
-        *errorMessage = "GitClient object is not valid.";
-        return false;
-    }
-    VcsBase::VcsCommand command(m_commonDirectory, git->processEnvironment());
-    QStringList args;
-
-    auto runCommand = [&]() -> bool {
-            auto response = command.runCommand(git->vcsBinary(), args, git->vcsTimeoutS());
-            if (response.result != SynchronousProcessResponse::Finished) {
-                *errorMessage = tr(response.exitMessage(git->vcsBinary().toString(),
-                                                        git->vcsTimeoutS()).toLatin1());
-                return false;
-            }
-            return true;
-    };
-
-    // Do initial commit?
-    if (versionControl->id() == Core::Id(VcsBase::Constants::VCS_ID_GIT)
-            && m_ui->initialCommitCheckBox->isChecked()) {
-        args = QStringList{"commit", "-m", "Initial commit"};
-        if (!runCommand())
-            return false;
-    }
-
-    // Add to remote?
-    if (versionControl->id() == Core::Id(VcsBase::Constants::VCS_ID_GIT)
-            && m_ui->initialCommitCheckBox->isChecked()
-            && !m_ui->gitRepoLineEdit->text().isEmpty()) {
-        args = QStringList{"remote", "add", "origin", m_ui->gitRepoLineEdit->text()};
-        if (!runCommand())
-            return false;
+void ProjectWizardPage::startGitPipeline(const QList<GeneratedFile> &files)
+{
+    GitClient *git = MiloPlugin::gitClient();
+    QTC_ASSERT(git, return);
+
+    const bool initialCommit = m_ui->initialCommitCheckBox->isChecked();
+    const QString remoteUrl = initialCommit ? m_ui->gitRepoLineEdit->text() : QString();
+
+    GitPipelineSetup setup;
+    setup.workingDirectory = m_commonDirectory;
+    setup.createRepository = !m_repositoryExists;
+    setup.files = Utils::transform(files, &GeneratedFile::path);
+    setup.commit = initialCommit;
+    setup.remoteUrl = remoteUrl;
+    setup.push = !remoteUrl.isEmpty() && m_ui->pushToRemoteCheckBox->isChecked();
+
+    // A brand-new repository and its first commit can be written without spawning git
+    // for every file, unless that was turned off in the settings.
+    const bool inProcessInitialCommit = ICore::settings()->value(
+                QLatin1String(Milo::Constants::IN_PROCESS_INITIAL_COMMIT_KEY), true).toBool();
+    if (setup.createRepository && setup.commit && inProcessInitialCommit) {
+        auto writer = QSharedPointer<InitialCommitWriter>::create(setup.workingDirectory, setup.files,
+                                                                  git->processEnvironment(),
+                                                                  git->vcsBinary());
+        QString reason;
+        if (writer->canWrite(&reason)) {
+            GitPipeline::executeWithInitialCommitWriter(writer, setup);
+            return;
+        }
+        VcsBase::VcsOutputWindow::appendSilently(tr("Using git for the initial commit: %1").arg(reason));
     }
 
-    // Push to remote?
-    if (versionControl->id() == Core::Id(VcsBase::Constants::VCS_ID_GIT)
-            && m_ui->initialCommitCheckBox->isChecked()
-            && !m_ui->gitRepoLineEdit->text().isEmpty()
-            && m_ui->pushToRemoteCheckBox->isChecked()) {
-        args = QStringList{"push", "-u", "origin", "master"};
-        if (!runCommand())
-            return false;
-    }
+    GitPipeline::execute(setup);
+}
 
-    return true;
+// Part of a project tree was replaced, and the nodes the project's cached subtree refers to may be
+// gone. Rebuild the project's subtree next time, or everything if the project is unknown.
+void ProjectWizardPage::projectSubtreeChanged(FolderNode *node)
+{
+    if (Project *project = SessionManager::projectForNode(node))
+        m_changedProjects.insert(project);
+    else
+        m_projectTreeInitialized = false;
 }
 
+// Only the subtrees of projects that were added, reparsed, changed their file list or had part of
+// their tree replaced since the previous call are rebuilt, and those of the projects the old and the
+// new context node belong to. A different path list or wizard kind affects every subtree and
+// triggers a full rebuild. Selection and expansion survive all but the first call.
 void ProjectWizardPage::initializeProjectTree(Node *context, const QStringList &paths,
                                               IWizardFactory::WizardKind kind,
                                               ProjectAction action)
 {
-    BestNodeSelector selector(m_commonDirectory, paths);
+    bool fullRebuild = !m_projectTreeInitialized || paths != m_projectTreePaths
+            || kind != m_projectTreeKind;
+    Project *contextProject = context ? SessionManager::projectForNode(context) : nullptr;
+    if (!fullRebuild && context != m_projectTreeContext) {
+        // The context node only matters to the items of its own project.
+        if ((context && !contextProject) || (m_projectTreeContext && !m_projectTreeContextProject)) {
+            fullRebuild = true;
+        } else {
+            if (m_projectTreeContextProject)
+                m_changedProjects.insert(m_projectTreeContextProject);
+            if (contextProject)
+                m_changedProjects.insert(contextProject);
+        }
+    }
+    m_projectTreeInitialized = true;
+    m_projectTreeContext = context;
+    m_projectTreeContextProject = contextProject;
+    m_projectTreePaths = paths;
+    m_projectTreeKind = kind;
+
+    QElapsedTimer timer;
+    timer.start();
+    int rebuiltProjects = 0;
 
+    BestNodeSelector selector(m_commonDirectory, paths);
     TreeItem *root = m_model.rootItem();
-    root->removeChildren();
+
+    // The "<None>" item is always the first one. Its text depends on the selector.
+    const bool restoreState = root->childCount() > 0;
+    const QModelIndex current = m_model.index(m_ui->projectComboBox->currentIndex(), 0,
+                                              m_ui->projectComboBox->rootModelIndex());
+    const bool noneSelected = current.isValid() && !current.parent().isValid() && current.row() == 0;
+    const QStringList selectedPath = current.isValid() && !noneSelected ? itemPath(current) : QStringList();
+    QSet<QString> expandedKeys;
+    if (restoreState)
+        saveExpandedItems(QModelIndex(), QString(), &expandedKeys);
+
+    if (fullRebuild) {
+        root->removeChildren();
+        for (const ProjectSubtree &subtree : m_projectSubtrees)
+            disconnect(subtree.fileListConnection);
+        m_projectSubtrees.clear();
+        m_changedProjects.clear();
+    } else if (root->childCount() > 0) {
+        m_model.destroyItem(root->childAt(0));
+    }
+
+    QHash<Project *, ProjectSubtree> subtrees;
+    QList<AddNewTree *> items;
     for (Project *project : SessionManager::projects()) {
-        if (ProjectNode *pn = project->rootProjectNode()) {
-            if (kind == IWizardFactory::ProjectWizard) {
-                if (AddNewTree *child = buildAddProjectTree(pn, paths.first(), context, &selector))
-                    root->appendChild(child);
-            } else {
-                if (AddNewTree *child = buildAddFilesTree(pn, paths, context, &selector))
-                    root->appendChild(child);
+        ProjectNode *pn = project->rootProjectNode();
+        ProjectSubtree subtree = m_projectSubtrees.take(project);
+        if (subtree.rootNode == pn && pn && !m_changedProjects.contains(project)) {
+            if (subtree.item) {
+                m_model.takeItem(subtree.item);
+                inspectAddNewTree(subtree.item, context, &selector);
+            }
+        } else {
+            if (subtree.item)
+                m_model.destroyItem(subtree.item);
+            subtree.rootNode = pn;
+            subtree.item = nullptr;
+            ++rebuiltProjects;
+            if (pn) {
+                if (kind == IWizardFactory::ProjectWizard)
+                    subtree.item = buildAddProjectTree(pn, paths.first(), context, &selector);
+                else
+                    subtree.item = buildAddFilesTree(pn, paths, context, &selector);
             }
         }
+        if (!subtree.fileListConnection) {
+            subtree.fileListConnection = connect(project, &Project::fileListChanged,
+                                                 this, [this, project]() {
+                m_changedProjects.insert(project);
+            });
+        }
+        if (subtree.item)
+            items.append(subtree.item);
+        subtrees.insert(project, subtree);
+    }
+
+    // Whatever is left belongs to projects that were closed in the meantime.
+    for (const ProjectSubtree &subtree : m_projectSubtrees) {
+        disconnect(subtree.fileListConnection);
+        if (subtree.item)
+            m_model.destroyItem(subtree.item);
     }
+    m_projectSubtrees = subtrees;
+    m_changedProjects.clear();
+
+    qCDebug(projectTreeLog) << "Built project tree in" << timer.elapsed() << "ms, rebuilt"
+                            << rebuiltProjects << "of" << subtrees.size() << "projects"
+                            << (fullRebuild ? "(full rebuild)" : "(incremental)");
+
+    for (AddNewTree *item : items)
+        root->appendChild(item);
     root->prependChild(createNoneNode(&selector));
 
+    setAdditionalInfo(selector.deployingProjects());
+    setAddingSubProject(action == AddSubProject);
+    m_ui->projectComboBox->setEnabled(m_model.rowCount(QModelIndex()) > 1);
+
+    if (restoreState) {
+        if (!expandedKeys.isEmpty())
+            restoreExpandedItems(QModelIndex(), QString(), expandedKeys);
+        const QModelIndex selected = noneSelected ? m_model.index(0, 0, QModelIndex())
+                                                  : indexForItemPath(selectedPath);
+        if (selected.isValid()) {
+            m_ui->projectComboBox->setCurrentIndex(selected);
+            return;
+        }
+    }
+
     // Set combobox to context node:
     auto predicate = [context](TreeItem *ti) { return static_cast<AddNewTree*>(ti)->node() == context; };
     TreeItem *contextItem = root->findAnyChild(predicate);
     m_ui->projectComboBox->setCurrentIndex(m_model.indexForItem(contextItem));
 
-    setAdditionalInfo(selector.deployingProjects());
     setBestNode(selector.bestChoice());
-    setAddingSubProject(action == AddSubProject);
-
-    m_ui->projectComboBox->setEnabled(m_model.rowCount(QModelIndex()) > 1);
 }
 
 void ProjectWizardPage::setNoneLabel(const QString &label)
@@ -562,43 +680,44 @@ IVersionControl *ProjectWizardPage::currentVersionControl()
 
 void ProjectWizardPage::setFiles(const QStringList &fileNames)
 {
+    // The file list is set again on every change of the summary settings,
+    // but it hardly ever differs.
+    if (!fileNames.isEmpty() && fileNames == m_files)
+        return;
+    m_files = fileNames;
+
+    QElapsedTimer timer;
+    timer.start();
+
     if (fileNames.count() == 1)
         m_commonDirectory = QFileInfo(fileNames.first()).absolutePath();
     else
         m_commonDirectory = Utils::commonPath(fileNames);
-    QString fileMessage;
-    {
-        QTextStream str(&fileMessage);
-        str << "<qt>"
-            << (m_commonDirectory.isEmpty() ? tr("Files to be added:") : tr("Files to be added in"))
-            << "<pre>";
-
-        QStringList formattedFiles;
-        if (m_commonDirectory.isEmpty()) {
-            formattedFiles = fileNames;
-        } else {
-            str << QDir::toNativeSeparators(m_commonDirectory) << ":\n\n";
-            const int prefixSize = m_commonDirectory.size() + 1;
-            formattedFiles = Utils::transform(fileNames, [prefixSize](const QString &f)
-                                                         { return f.mid(prefixSize); });
-        }
-        // Alphabetically, and files in sub-directories first
-        Utils::sort(formattedFiles, [](const QString &filePath1, const QString &filePath2) -> bool {
-            const bool filePath1HasDir = filePath1.contains(QLatin1Char('/'));
-            const bool filePath2HasDir = filePath2.contains(QLatin1Char('/'));
-
-            if (filePath1HasDir == filePath2HasDir)
-                return FileName::fromString(filePath1) < FileName::fromString(filePath2);
-            return filePath1HasDir;
-        }
-);
-
-        foreach (const QString &f, formattedFiles)
-            str << QDir::toNativeSeparators(f) << '\n';
 
-        str << "</pre>";
+    QStringList formattedFiles;
+    if (m_commonDirectory.isEmpty()) {
+        m_ui->filesLabel->setText(tr("Files to be added:"));
+        formattedFiles = fileNames;
+    } else {
+        m_ui->filesLabel->setText(tr("Files to be added in %1:")
+                                  .arg(QDir::toNativeSeparators(m_commonDirectory)));
+        const int prefixSize = m_commonDirectory.size() + 1;
+        formattedFiles = Utils::transform(fileNames, [prefixSize](const QString &f)
+                                                     { return f.mid(prefixSize); });
     }
-    m_ui->filesLabel->setText(fileMessage);
+    m_filesModel->setFiles(formattedFiles);
+    if (m_ui->groupByDirectoryCheckBox->isChecked())
+        m_ui->filesView->expandAll();
+
+    qCDebug(fileListLog) << "Listed" << fileNames.size() << "files in" << timer.elapsed() << "ms";
+}
+
+void ProjectWizardPage::groupFilesByDirectory(bool group)
+{
+    m_filesModel->setGroupByDirectory(group);
+    m_ui->filesView->setRootIsDecorated(group);
+    if (group)
+        m_ui->filesView->expandAll();
 }
 
 void ProjectWizardPage::setProjectToolTip(const QString &tt)
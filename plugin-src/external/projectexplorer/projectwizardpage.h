@@ -35,6 +35,9 @@
 #include <utils/wizardpage.h>
 #include <utils/treemodel.h>
 
+#include <QHash>
+#include <QSet>
+
 QT_BEGIN_NAMESPACE
 class QTreeView;
 class QModelIndex;
@@ -43,9 +46,13 @@ QT_END_NAMESPACE
 namespace Core { class IVersionControl; }
 
 namespace ProjectExplorer {
+
+class Project;
+
 namespace Internal {
 
 class AddNewTree;
+class GeneratedFilesModel;
 
 namespace Ui { class WizardPage; }
 
@@ -84,7 +91,10 @@ signals:
 
 private:
     void projectChanged(int);
+    void projectSubtreeChanged(FolderNode *node);
     void manageVcs();
+    void groupFilesByDirectory(bool group);
+    void startGitPipeline(const QList<Core::GeneratedFile> &files);
     void hideVersionControlUiElements();
     void updateGitRepositoryUiElements();
     void updateInitialCommitUiElements();
@@ -96,11 +106,33 @@ private:
     void setVersionControls(const QStringList &);
     void setProjectToolTip(const QString &);
     bool expandTree(const QModelIndex &root);
+    void saveExpandedItems(const QModelIndex &parent, const QString &parentKey,
+                           QSet<QString> *expandedKeys) const;
+    void restoreExpandedItems(const QModelIndex &parent, const QString &parentKey,
+                              const QSet<QString> &expandedKeys);
+    QStringList itemPath(const QModelIndex &index) const;
+    QModelIndex indexForItemPath(const QStringList &path) const;
 
     Ui::WizardPage *m_ui;
+    GeneratedFilesModel *m_filesModel;
+    QStringList m_files;
     QStringList m_projectToolTips;
     Utils::TreeModel<> m_model;
 
+    struct ProjectSubtree
+    {
+        ProjectNode *rootNode = nullptr;
+        AddNewTree *item = nullptr;
+        QMetaObject::Connection fileListConnection;
+    };
+    QHash<Project *, ProjectSubtree> m_projectSubtrees;
+    QSet<Project *> m_changedProjects;
+    bool m_projectTreeInitialized = false;
+    Node *m_projectTreeContext = nullptr;
+    Project *m_projectTreeContextProject = nullptr;
+    QStringList m_projectTreePaths;
+    Core::IWizardFactory::WizardKind m_projectTreeKind = Core::IWizardFactory::ProjectWizard;
+
     QList<Core::IVersionControl*> m_activeVersionControls;
     QString m_commonDirectory;
     bool m_repositoryExists = false;
@@ -3,7 +3,12 @@ DEFINES += MILO_LIBRARY
 # Milo files
 
 SOURCES += miloplugin.cpp \
+    milogitpipeline.cpp \
+    miloinitialcommitwriter.cpp \
+    milologging.cpp \
+    milopushqueue.cpp \
     external/projectexplorer/jsonwizard/jsonsummarypage.cpp \
+    external/projectexplorer/addnewtree.cpp \
     external/projectexplorer/projectwizardpage.cpp \
     external/git/gitclient.cpp \
     external/git/gitsettings.cpp
@@ -11,7 +16,12 @@ SOURCES += miloplugin.cpp \
 HEADERS += miloplugin.h \
     milo_global.h \
     miloconstants.h \
+    milogitpipeline.h \
+    miloinitialcommitwriter.h \
+    milologging.h \
+    milopushqueue.h \
     external/projectexplorer/jsonwizard/jsonsummarypage.h \
+    external/projectexplorer/addnewtree.h \
     external/projectexplorer/projectwizardpage.h \
     external/git/gitclient.h \
     external/git/gitsettings.h
@@ -20,6 +30,17 @@ INCLUDEPATH += external/projectexplorer \
     external/projectexplorer/jsonwizard \
     external/git
 
+# Plugin tests, build with "qmake TEST=1" and run with "qtcreator -test Milo"
+
+equals(TEST, 1) {
+    SOURCES += milotestutils.cpp \
+        milogitpipeline_test.cpp \
+        milopushqueue_test.cpp \
+        milowizardpage_test.cpp
+
+    HEADERS += milotestutils.h
+}
+
 # Qt Creator linking
 
 ## Either set the IDE_SOURCE_TREE when running qmake,
@@ -6,5 +6,8 @@ namespace Constants {
 const char ACTION_ID[] = "Milo.Action";
 const char MENU_ID[] = "Milo.Menu";
 
+// Set to false to have the git command line create new repositories and their initial commit.
+const char IN_PROCESS_INITIAL_COMMIT_KEY[] = "Milo/InProcessInitialCommit";
+
 } // namespace Milo
 } // namespace Constants
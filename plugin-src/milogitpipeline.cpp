@@ -0,0 +1,140 @@
+#include "milogitpipeline.h"
+#include "miloinitialcommitwriter.h"
+#include "milologging.h"
+#include "miloplugin.h"
+#include "milopushqueue.h"
+
+#include "gitclient.h"
+
+#include <coreplugin/progressmanager/progressmanager.h>
+#include <coreplugin/vcsmanager.h>
+#include <utils/qtcassert.h>
+#include <utils/runextensions.h>
+#include <vcsbase/vcsoutputwindow.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
+using namespace Core;
+using namespace Git::Internal;
+
+namespace Milo {
+namespace Internal {
+
+// Runs the steps in the background with a progress indicator that allows to cancel them.
+// The command deletes itself when done. Returns nullptr if there is nothing to run git for.
+GitCommandRunner *GitPipeline::execute(const GitPipelineSetup &setup)
+{
+    GitCommandRunner *command = createCommand(setup);
+    if (!command) {
+        // Push to remote? The push queue takes care of it once the commit is there, so that
+        // a slow or flaky remote neither holds up nor fails the steps above.
+        VcsManager::resetVersionControlForDirectory(setup.workingDirectory);
+        if (setup.push)
+            MiloPlugin::pushQueue()->enqueue(setup.workingDirectory);
+        return nullptr;
+    }
+    command->execute();
+    return command;
+}
+
+// Queues the steps as jobs of a single command, without starting it. Returns nullptr if
+// there is nothing to run git for.
+GitCommandRunner *GitPipeline::createCommand(const GitPipelineSetup &setup)
+{
+    GitClient *git = MiloPlugin::gitClient();
+    QTC_ASSERT(git, return nullptr);
+
+    // Stage all files in a few batches instead of spawning git once per file.
+    const QList<QStringList> chunks = GitClient::chunkedFileArguments(setup.workingDirectory,
+                                                                      setup.files);
+
+    const QString workingDirectory = setup.workingDirectory;
+    const bool push = setup.push;
+    if (!setup.createRepository && chunks.isEmpty() && !setup.commit && setup.remoteUrl.isEmpty())
+        return nullptr;
+
+    GitCommandRunner *command = git->createCommandRunner(workingDirectory, tr("Initial Commit"));
+
+    // Create repository?
+    if (setup.createRepository)
+        command->addGitJob({"init"});
+
+    for (const QStringList &chunk : chunks)
+        command->addStagingJob(chunk);
+
+    // Do initial commit?
+    if (setup.commit)
+        command->addGitJob({"commit", "-m", "Initial commit"});
+
+    // Add to remote?
+    if (!setup.remoteUrl.isEmpty())
+        command->addGitJob({"remote", "add", "origin", setup.remoteUrl});
+
+    QObject::connect(command, &GitCommandRunner::jobFinished,
+                     [](const QStringList &arguments, bool success, qint64 elapsedMs) {
+        qCDebug(versionControlLog) << "git" << arguments.mid(0, 2) << (success ? "succeeded" : "failed")
+                                   << "in" << elapsedMs << "ms";
+    });
+
+    QObject::connect(command, &VcsBase::VcsCommand::finished,
+                     command, [command, workingDirectory, push](bool ok, int exitCode, const QVariant &) {
+        VcsManager::resetVersionControlForDirectory(workingDirectory);
+        const QString failedFile = command->failedFile();
+        if (!ok && !failedFile.isEmpty()) {
+            VcsBase::VcsOutputWindow::appendError(
+                        tr("Failed to add \"%1\" to the version control system: %2")
+                        .arg(QDir::toNativeSeparators(QDir(workingDirectory).absoluteFilePath(failedFile)),
+                             command->failedFileError()));
+        } else if (!ok) {
+            VcsBase::VcsOutputWindow::appendError(
+                        tr("Failed to commit \"%1\" to the version control system (exit code %2).")
+                        .arg(QDir::toNativeSeparators(workingDirectory)).arg(exitCode));
+        } else if (push) {
+            MiloPlugin::pushQueue()->enqueue(workingDirectory);
+        }
+    });
+    return command;
+}
+
+// Writes repository and initial commit in a worker thread. The command line takes over
+// whatever is left to do, or everything if the writer fails.
+void GitPipeline::executeWithInitialCommitWriter(const QSharedPointer<InitialCommitWriter> &writer,
+                                                 const GitPipelineSetup &setup)
+{
+    QFuture<bool> future = Utils::runAsync([writer](QFutureInterface<bool> &futureInterface) {
+        QElapsedTimer timer;
+        timer.start();
+        writer->run(futureInterface);
+        qCDebug(versionControlLog) << "Wrote initial commit in-process in" << timer.elapsed() << "ms";
+    });
+    ProgressManager::addTask(future, tr("Initial Commit"), "Milo.InitialCommit");
+
+    auto watcher = new QFutureWatcher<bool>;
+    QObject::connect(watcher, &QFutureWatcher<bool>::finished, [watcher, writer, setup]() {
+        watcher->deleteLater();
+        // The writer reports a result once it ran to the end, even if the task was canceled
+        // after that. Without one it was canceled before or while writing.
+        if (watcher->future().resultCount() == 0) {
+            VcsManager::resetVersionControlForDirectory(setup.workingDirectory);
+            if (!writer->errorMessage().isEmpty())
+                VcsBase::VcsOutputWindow::appendError(writer->errorMessage());
+            return;
+        }
+
+        GitPipelineSetup remaining = setup;
+        if (watcher->result()) {
+            remaining.createRepository = false;
+            remaining.files.clear();
+            remaining.commit = false;
+        } else {
+            VcsBase::VcsOutputWindow::appendWarning(writer->errorMessage());
+        }
+        execute(remaining);
+    });
+    watcher->setFuture(future);
+}
+
+} // namespace Internal
+} // namespace Milo
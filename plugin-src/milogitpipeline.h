@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QSharedPointer>
+#include <QStringList>
+
+namespace Git {
+namespace Internal {
+class GitCommandRunner;
+} // namespace Internal
+} // namespace Git
+
+namespace Milo {
+namespace Internal {
+
+class InitialCommitWriter;
+
+// Everything the background git steps need, copied so that they can outlive the wizard.
+struct GitPipelineSetup
+{
+    QString workingDirectory;
+    bool createRepository = false;
+    QStringList files;
+    bool commit = false;
+    QString remoteUrl;
+    bool push = false;
+};
+
+// The git steps of the summary page. They run in the background, failures end up in the
+// Version Control output pane.
+class GitPipeline
+{
+    Q_DECLARE_TR_FUNCTIONS(Milo::Internal::GitPipeline)
+
+public:
+    static Git::Internal::GitCommandRunner *execute(const GitPipelineSetup &setup);
+    static Git::Internal::GitCommandRunner *createCommand(const GitPipelineSetup &setup);
+    static void executeWithInitialCommitWriter(const QSharedPointer<InitialCommitWriter> &writer,
+                                               const GitPipelineSetup &setup);
+};
+
+} // namespace Internal
+} // namespace Milo
@@ -0,0 +1,99 @@
+#include "miloplugin.h"
+#include "milogitpipeline.h"
+#include "milotestutils.h"
+
+#include "gitclient.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace Git::Internal;
+using namespace Milo::Internal::Tests;
+
+namespace Milo {
+namespace Internal {
+
+void MiloPlugin::testGitPipeline()
+{
+    const GitIdentity identity;
+    QTemporaryDir remote;
+    QTemporaryDir project;
+    QVERIFY(remote.isValid());
+    QVERIFY(project.isValid());
+    QVERIFY(runGit(remote.path(), {"init", "--bare"}));
+
+    // Enough files for more than one "git add" batch.
+    const QString directory = project.path() + '/' + QString(100, QLatin1Char('d'));
+    QStringList files;
+    for (int i = 0; i < 400; ++i) {
+        files << directory + QString("/file%1.cpp").arg(i);
+        QVERIFY(writeFile(files.last(), QByteArray::number(i)));
+    }
+    QVERIFY(GitClient::chunkedFileArguments(project.path(), files).size() > 1);
+
+    GitPipelineSetup setup;
+    setup.workingDirectory = project.path();
+    setup.createRepository = true;
+    setup.files = files;
+    setup.commit = true;
+    setup.remoteUrl = remote.path();
+
+    // Connect before starting: the command finishes in its worker thread.
+    GitCommandRunner *command = GitPipeline::createCommand(setup);
+    QVERIFY(command);
+    QSignalSpy finished(command, &VcsBase::VcsCommand::finished);
+    command->execute();
+    QVERIFY(!finished.isEmpty() || finished.wait(60000));
+    QVERIFY(finished.first().at(0).toBool());
+    QVERIFY(!QApplication::activeModalWidget());
+
+    QString output;
+    QVERIFY(runGit(project.path(), {"log", "--format=%s"}, &output));
+    QCOMPARE(output.trimmed(), QString("Initial commit"));
+    QVERIFY(runGit(project.path(), {"ls-files"}, &output));
+    QCOMPARE(output.split('\n', QString::SkipEmptyParts).size(), files.size());
+    QVERIFY(runGit(project.path(), {"status", "--porcelain"}, &output));
+    QVERIFY(output.isEmpty());
+    QVERIFY(runGit(project.path(), {"config", "remote.origin.url"}, &output));
+    QCOMPARE(output.trimmed(), remote.path());
+    QVERIFY(runGit(project.path(), {"ls-remote", "origin"}));
+}
+
+// A file git refuses to add fails the pipeline. The file is named in the output pane,
+// and nothing asks the user about it.
+void MiloPlugin::testGitPipelineFailure()
+{
+    const GitIdentity identity;
+    QTemporaryDir project;
+    QVERIFY(project.isValid());
+
+    const QStringList files = {project.path() + "/.gitignore",
+                               project.path() + "/main.cpp",
+                               project.path() + "/build.log"};
+    QVERIFY(writeFile(files.at(0), "*.log\n"));
+    QVERIFY(writeFile(files.at(1), "int main() { return 0; }\n"));
+    QVERIFY(writeFile(files.at(2), "ignored\n"));
+
+    GitPipelineSetup setup;
+    setup.workingDirectory = project.path();
+    setup.createRepository = true;
+    setup.files = files;
+    setup.commit = true;
+
+    GitCommandRunner *command = GitPipeline::createCommand(setup);
+    QVERIFY(command);
+    QSignalSpy finished(command, &VcsBase::VcsCommand::finished);
+    command->execute();
+    QVERIFY(!finished.isEmpty() || finished.wait(60000));
+    QVERIFY(!finished.first().at(0).toBool());
+
+    QVERIFY(versionControlOutput().contains(QDir::toNativeSeparators(files.at(2))));
+    QVERIFY(!QApplication::activeModalWidget());
+    QVERIFY(!runGit(project.path(), {"rev-parse", "--verify", "--quiet", "HEAD"}));
+}
+
+} // namespace Internal
+} // namespace Milo
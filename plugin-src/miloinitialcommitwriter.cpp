@@ -0,0 +1,458 @@
+#include "miloinitialcommitwriter.h"
+
+#include <utils/hostosinfo.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QtEndian>
+
+#include <algorithm>
+
+using namespace Utils;
+
+namespace Milo {
+namespace Internal {
+
+static const char INITIAL_COMMIT_MESSAGE[] = "Initial commit";
+
+// --------------------------------------------------------------------
+// Helper:
+// --------------------------------------------------------------------
+
+static void appendUInt32(QByteArray &data, quint32 value)
+{
+    uchar buffer[4];
+    qToBigEndian(value, buffer);
+    data.append(reinterpret_cast<const char *>(buffer), 4);
+}
+
+static void appendUInt16(QByteArray &data, quint16 value)
+{
+    uchar buffer[2];
+    qToBigEndian(value, buffer);
+    data.append(reinterpret_cast<const char *>(buffer), 2);
+}
+
+static bool isTrue(const QString &value)
+{
+    // A key without "=" is a boolean true in git config files.
+    const QString v = value.toLower();
+    return v.isEmpty() || v == "true" || v == "yes" || v == "on" || v == "1";
+}
+
+static QByteArray timestamp()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const int offset = now.offsetFromUtc() / 60;
+    const int absoluteOffset = qAbs(offset);
+    return QByteArray::number(now.toMSecsSinceEpoch() / 1000) + ' '
+            + (offset < 0 ? '-' : '+')
+            + QByteArray::number(absoluteOffset / 60).rightJustified(2, '0')
+            + QByteArray::number(absoluteOffset % 60).rightJustified(2, '0');
+}
+
+// --------------------------------------------------------------------
+// InitialCommitWriter:
+// --------------------------------------------------------------------
+
+InitialCommitWriter::InitialCommitWriter(const QString &workingDirectory, const QStringList &files,
+                                         const QProcessEnvironment &environment,
+                                         const FileName &gitBinary) :
+    m_workingDirectory(QDir::cleanPath(workingDirectory)),
+    m_gitDir(m_workingDirectory + "/.git"),
+    m_files(files),
+    m_environment(environment),
+    m_gitBinary(gitBinary)
+{
+    m_files.removeDuplicates();
+}
+
+bool InitialCommitWriter::canWrite(QString *reason)
+{
+    QString message;
+    if (!reason)
+        reason = &message;
+
+    // Variables that redirect the repository or the configuration.
+    for (const QString &key : m_environment.keys()) {
+        if ((key.startsWith("GIT_CONFIG") && key != "GIT_CONFIG_NOSYSTEM")
+                || key == "GIT_DIR" || key == "GIT_WORK_TREE" || key == "GIT_INDEX_FILE"
+                || key == "GIT_OBJECT_DIRECTORY" || key == "GIT_TEMPLATE_DIR"
+                || key == "GIT_AUTHOR_DATE" || key == "GIT_COMMITTER_DATE") {
+            *reason = tr("The environment variable %1 is set.").arg(key);
+            return false;
+        }
+    }
+
+    if (m_files.isEmpty()) {
+        *reason = tr("There are no files to commit.");
+        return false;
+    }
+    if (QFileInfo::exists(m_gitDir)) {
+        *reason = tr("\"%1\" already exists.").arg(QDir::toNativeSeparators(m_gitDir));
+        return false;
+    }
+
+    const QDir workingDir(m_workingDirectory);
+    for (const QString &filePath : m_files) {
+        const QFileInfo fi(filePath);
+        const QString relativePath = workingDir.relativeFilePath(filePath);
+        if (fi.isSymLink() || !fi.isFile() || relativePath.startsWith("../")
+                || QDir::isAbsolutePath(relativePath)) {
+            *reason = tr("\"%1\" is not a regular file inside the repository.")
+                    .arg(QDir::toNativeSeparators(filePath));
+            return false;
+        }
+        // Attributes may request filters, line ending conversion and the like.
+        if (fi.fileName() == ".gitattributes" || relativePath.split('/').contains(".git")) {
+            *reason = tr("\"%1\" needs to be handled by git.").arg(QDir::toNativeSeparators(filePath));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Asks git for the configuration the new repository gets, from all the places git reads it from,
+// with includes resolved.
+bool InitialCommitWriter::readConfig()
+{
+    if (m_gitBinary.isEmpty())
+        return fail(tr("Cannot read the git configuration without a git executable."));
+
+    // Leave out the configuration of a repository the new one is nested in.
+    QProcessEnvironment environment = m_environment;
+    environment.insert("GIT_CEILING_DIRECTORIES", QFileInfo(m_workingDirectory).absolutePath());
+
+    QProcess process;
+    process.setWorkingDirectory(m_workingDirectory);
+    process.setProcessEnvironment(environment);
+    process.start(m_gitBinary.toString(), {"config", "--list", "-z"});
+    if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit
+            || process.exitCode() != 0) {
+        return fail(tr("Cannot read the git configuration: %1")
+                    .arg(QString::fromLocal8Bit(process.readAllStandardError()).trimmed()));
+    }
+
+    // Entries are "key\nvalue", or just "key" for a boolean true. Section and key names
+    // come in lower case.
+    for (const QByteArray &entry : process.readAllStandardOutput().split('\0')) {
+        if (entry.isEmpty())
+            continue;
+        const int newline = entry.indexOf('\n');
+        if (newline < 0) {
+            m_config.insert(QString::fromUtf8(entry), QString());
+        } else {
+            m_config.insert(QString::fromUtf8(entry.left(newline)),
+                            QString::fromUtf8(entry.mid(newline + 1)));
+        }
+    }
+
+    for (auto it = m_config.cbegin(), end = m_config.cend(); it != end; ++it) {
+        const QString &key = it.key();
+        const QString &value = it.value();
+        // Conditional includes may apply once the repository exists.
+        const bool needsGit = key.startsWith("includeif.")
+                || key.startsWith("author.") || key.startsWith("committer.")
+                || (key == "commit.gpgsign" && isTrue(value))
+                || (key == "core.hookspath" && !value.isEmpty())
+                || (key == "init.templatedir" && !value.isEmpty())
+                || (key == "core.attributesfile" && !value.isEmpty())
+                || (key == "core.autocrlf" && value.toLower() != "false")
+                || (key == "core.sharedrepository" && !value.isEmpty())
+                || (key == "init.defaultobjectformat" && value.toLower() != "sha1");
+        if (needsGit)
+            return fail(tr("The git configuration sets \"%1\".").arg(key));
+    }
+
+    const QString branch = m_config.value("init.defaultbranch", "master");
+    static const QRegularExpression branchName("^[A-Za-z0-9_-]+(/[A-Za-z0-9_-]+)*$");
+    if (!branchName.match(branch).hasMatch())
+        return fail(tr("The default branch name \"%1\" needs to be checked by git.").arg(branch));
+    m_branch = branch.toUtf8();
+    return true;
+}
+
+bool InitialCommitWriter::resolveIdentity()
+{
+    const QString configName = m_config.value("user.name");
+    QString configEmail = m_config.value("user.email");
+    if (configEmail.isEmpty())
+        configEmail = m_environment.value("EMAIL");
+
+    auto ident = [&](const QString &nameVariable, const QString &emailVariable) -> QByteArray {
+        const QString name = m_environment.value(nameVariable, configName).trimmed();
+        const QString email = m_environment.value(emailVariable, configEmail).trimmed();
+        static const QRegularExpression invalid("[<>\\n]");
+        if (name.isEmpty() || email.isEmpty() || name.contains(invalid) || email.contains(invalid))
+            return QByteArray();
+        return name.toUtf8() + " <" + email.toUtf8() + "> ";
+    };
+
+    m_author = ident("GIT_AUTHOR_NAME", "GIT_AUTHOR_EMAIL");
+    m_committer = ident("GIT_COMMITTER_NAME", "GIT_COMMITTER_EMAIL");
+    if (m_author.isEmpty() || m_committer.isEmpty())
+        return fail(tr("No usable user name and email address are configured."));
+    return true;
+}
+
+void InitialCommitWriter::run(QFutureInterface<bool> &futureInterface)
+{
+    const bool ok = write(futureInterface);
+    // Leave nothing behind, so that the command line fallback starts from scratch.
+    if (!ok)
+        QDir(m_gitDir).removeRecursively();
+    futureInterface.reportResult(ok);
+}
+
+bool InitialCommitWriter::write(QFutureInterface<bool> &futureInterface)
+{
+    futureInterface.setProgressRange(0, m_files.size() + 1);
+    if (!readConfig() || !resolveIdentity() || !writeRepositoryLayout() || !checkIgnoredFiles())
+        return false;
+
+    const QDir workingDir(m_workingDirectory);
+    m_entries.reserve(m_files.size());
+    for (int i = 0; i < m_files.size(); ++i) {
+        if (futureInterface.isCanceled())
+            return fail(tr("The initial commit was canceled."));
+
+        const QString &filePath = m_files.at(i);
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly))
+            return fail(tr("Cannot read \"%1\".").arg(QDir::toNativeSeparators(filePath)));
+
+        IndexEntry entry;
+        entry.path = workingDir.relativeFilePath(filePath).toUtf8();
+        entry.filePath = filePath;
+        entry.mode = !HostOsInfo::isWindowsHost() && file.permissions().testFlag(QFile::ExeUser)
+                ? 0100755 : 0100644;
+        if (!writeObject("blob", file.readAll(), &entry.id))
+            return false;
+        m_entries.append(entry);
+        futureInterface.setProgressValue(i + 1);
+    }
+
+    // Both the index and the trees expect byte-wise ordered paths.
+    std::sort(m_entries.begin(), m_entries.end(), [](const IndexEntry &e1, const IndexEntry &e2) {
+        return e1.path < e2.path;
+    });
+
+    QByteArray treeId;
+    if (!writeTree(0, m_entries.size(), 0, &treeId))
+        return false;
+
+    const QByteArray time = timestamp();
+    const QByteArray committer = m_committer + time;
+    const QByteArray commit = "tree " + treeId.toHex() + '\n'
+            + "author " + m_author + time + '\n'
+            + "committer " + committer + '\n'
+            + '\n'
+            + INITIAL_COMMIT_MESSAGE + '\n';
+    if (!writeObject("commit", commit, &m_commitId))
+        return false;
+
+    if (!writeIndex())
+        return false;
+
+    const QString branchRef = "refs/heads/" + QString::fromUtf8(m_branch);
+    const QByteArray reflog = QByteArray(40, '0') + ' ' + m_commitId.toHex() + ' ' + committer
+            + "\tcommit (initial): " + INITIAL_COMMIT_MESSAGE + '\n';
+    const bool ok = writeFile(branchRef, m_commitId.toHex() + '\n')
+            && writeFile("logs/HEAD", reflog)
+            && writeFile("logs/" + branchRef, reflog);
+    futureInterface.setProgressValue(m_files.size() + 1);
+    return ok;
+}
+
+// Mirrors what "git init" creates from the default template, minus the sample hooks.
+bool InitialCommitWriter::writeRepositoryLayout()
+{
+    const QDir gitDir(m_gitDir);
+    const QStringList directories = {"hooks", "info", "objects/info", "objects/pack",
+                                     "refs/heads", "refs/tags"};
+    for (const QString &directory : directories) {
+        if (!gitDir.mkpath(directory))
+            return fail(tr("Cannot create \"%1\".").arg(QDir::toNativeSeparators(gitDir.filePath(directory))));
+    }
+
+    QByteArray config = "[core]\n"
+                        "\trepositoryformatversion = 0\n";
+    config += HostOsInfo::isWindowsHost() ? "\tfilemode = false\n" : "\tfilemode = true\n";
+    config += "\tbare = false\n"
+              "\tlogallrefupdates = true\n";
+    if (HostOsInfo::isWindowsHost())
+        config += "\tsymlinks = false\n";
+    if (!HostOsInfo::isLinuxHost())
+        config += "\tignorecase = true\n";
+    if (HostOsInfo::isMacHost())
+        config += "\tprecomposeunicode = true\n";
+
+    return writeFile("HEAD", "ref: refs/heads/" + m_branch + '\n')
+            && writeFile("config", config)
+            && writeFile("description", "Unnamed repository; edit this file 'description' to name the repository.\n")
+            && writeFile("info/exclude", "# git ls-files --others --exclude-from=.git/info/exclude\n"
+                                         "# Lines that start with '#' are comments.\n");
+}
+
+// "git add" refuses files that are ignored, by a generated .gitignore or by the user's global
+// excludes for example. Let git decide, now that there is a repository to ask.
+bool InitialCommitWriter::checkIgnoredFiles()
+{
+    if (m_gitBinary.isEmpty())
+        return fail(tr("Cannot check for ignored files without a git executable."));
+
+    const QDir workingDir(m_workingDirectory);
+    QByteArray paths;
+    for (const QString &filePath : m_files) {
+        paths.append(workingDir.relativeFilePath(filePath).toUtf8());
+        paths.append('\0');
+    }
+
+    QProcess process;
+    process.setWorkingDirectory(m_workingDirectory);
+    process.setProcessEnvironment(m_environment);
+    process.start(m_gitBinary.toString(), {"check-ignore", "--stdin", "-z"});
+    process.write(paths);
+    process.closeWriteChannel();
+    // Exit code 1 means that no file is ignored.
+    if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit
+            || (process.exitCode() != 0 && process.exitCode() != 1)) {
+        return fail(tr("Cannot check for ignored files: %1")
+                    .arg(QString::fromLocal8Bit(process.readAllStandardError()).trimmed()));
+    }
+    if (process.exitCode() == 1)
+        return true;
+
+    const QString ignored = QString::fromUtf8(process.readAllStandardOutput().split('\0').first());
+    return fail(tr("\"%1\" is ignored by git.")
+                .arg(QDir::toNativeSeparators(workingDir.absoluteFilePath(ignored))));
+}
+
+bool InitialCommitWriter::writeObject(const QByteArray &type, const QByteArray &content, QByteArray *id)
+{
+    QByteArray object = type + ' ' + QByteArray::number(content.size());
+    object.append('\0');
+    object.append(content);
+    *id = QCryptographicHash::hash(object, QCryptographicHash::Sha1);
+
+    const QString hex = QString::fromLatin1(id->toHex());
+    const QString relativePath = "objects/" + hex.left(2) + '/' + hex.mid(2);
+    if (QFileInfo::exists(QDir(m_gitDir).filePath(relativePath)))
+        return true;
+
+    // qCompress() prepends the uncompressed size to a regular zlib stream.
+    const QByteArray compressed = qCompress(object);
+    if (!writeFile(relativePath, compressed.mid(4)))
+        return false;
+    QFile::setPermissions(QDir(m_gitDir).filePath(relativePath),
+                          QFile::ReadOwner | QFile::ReadUser | QFile::ReadGroup | QFile::ReadOther);
+    return true;
+}
+
+// Writes the tree for the entries in [begin, end), which all share a prefix of prefixLength bytes.
+bool InitialCommitWriter::writeTree(int begin, int end, int prefixLength, QByteArray *id)
+{
+    struct TreeEntry
+    {
+        QByteArray sortKey;
+        QByteArray data;
+    };
+    QVector<TreeEntry> treeEntries;
+
+    for (int i = begin; i < end; ) {
+        const IndexEntry &entry = m_entries.at(i);
+        const int slash = entry.path.indexOf('/', prefixLength);
+        if (slash < 0) {
+            const QByteArray name = entry.path.mid(prefixLength);
+            QByteArray data = QByteArray::number(entry.mode, 8) + ' ' + name;
+            data.append('\0');
+            data.append(entry.id);
+            treeEntries.append({name, data});
+            ++i;
+            continue;
+        }
+
+        const QByteArray directory = entry.path.left(slash + 1);
+        int next = i + 1;
+        while (next < end && m_entries.at(next).path.startsWith(directory))
+            ++next;
+        QByteArray subtreeId;
+        if (!writeTree(i, next, slash + 1, &subtreeId))
+            return false;
+
+        // Git sorts directories as if their names ended with a slash.
+        const QByteArray name = entry.path.mid(prefixLength, slash - prefixLength);
+        QByteArray data = "40000 " + name;
+        data.append('\0');
+        data.append(subtreeId);
+        treeEntries.append({name + '/', data});
+        i = next;
+    }
+
+    std::sort(treeEntries.begin(), treeEntries.end(), [](const TreeEntry &e1, const TreeEntry &e2) {
+        return e1.sortKey < e2.sortKey;
+    });
+    QByteArray tree;
+    for (const TreeEntry &treeEntry : treeEntries)
+        tree.append(treeEntry.data);
+    return writeObject("tree", tree, id);
+}
+
+// Index format version 2. Device and inode numbers are left empty, git refreshes
+// the stat information the first time it compares the work tree to the index.
+bool InitialCommitWriter::writeIndex()
+{
+    QByteArray index = "DIRC";
+    appendUInt32(index, 2);
+    appendUInt32(index, quint32(m_entries.size()));
+
+    for (const IndexEntry &entry : m_entries) {
+        const QFileInfo fi(entry.filePath);
+        const qint64 modified = fi.lastModified().toMSecsSinceEpoch();
+        const int entryStart = index.size();
+        for (int i = 0; i < 2; ++i) { // ctime and mtime
+            appendUInt32(index, quint32(modified / 1000));
+            appendUInt32(index, quint32(modified % 1000) * 1000000);
+        }
+        appendUInt32(index, 0); // dev
+        appendUInt32(index, 0); // ino
+        appendUInt32(index, entry.mode);
+        appendUInt32(index, fi.ownerId());
+        appendUInt32(index, fi.groupId());
+        appendUInt32(index, quint32(fi.size()));
+        index.append(entry.id);
+        appendUInt16(index, quint16(qMin(entry.path.size(), 0xfff)));
+        index.append(entry.path);
+        // At least one NUL, padding the entry to a multiple of eight bytes.
+        const int entrySize = index.size() - entryStart;
+        index.append(QByteArray(8 - entrySize % 8, '\0'));
+    }
+
+    index.append(QCryptographicHash::hash(index, QCryptographicHash::Sha1));
+    return writeFile("index", index);
+}
+
+bool InitialCommitWriter::writeFile(const QString &relativePath, const QByteArray &content)
+{
+    const QString filePath = QDir(m_gitDir).filePath(relativePath);
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+        return fail(tr("Cannot write \"%1\".").arg(QDir::toNativeSeparators(filePath)));
+    return true;
+}
+
+bool InitialCommitWriter::fail(const QString &message)
+{
+    m_errorMessage = message;
+    return false;
+}
+
+} // namespace Internal
+} // namespace Milo
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFutureInterface>
+#include <QHash>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QVector>
+
+namespace Milo {
+namespace Internal {
+
+// Creates a repository with an initial commit of the given files without running git for
+// each of them: the blob, tree and commit objects, the index, the refs and the reflogs are
+// written directly. Git only runs to read the configuration and to find out whether it ignores
+// any of the files. Files that need real git (attributes) make canWrite() fail. Configuration
+// that does (hooks, signing, custom templates, ...) and ignored files make run() fail. The
+// caller uses the git CLI then.
+class InitialCommitWriter
+{
+    Q_DECLARE_TR_FUNCTIONS(Milo::Internal::InitialCommitWriter)
+
+public:
+    InitialCommitWriter(const QString &workingDirectory, const QStringList &files,
+                        const QProcessEnvironment &environment,
+                        const Utils::FileName &gitBinary);
+
+    bool canWrite(QString *reason = nullptr);
+    void run(QFutureInterface<bool> &futureInterface);
+
+    QString errorMessage() const { return m_errorMessage; }
+    QByteArray commitId() const { return m_commitId; }
+
+private:
+    struct IndexEntry
+    {
+        QByteArray path;
+        QString filePath;
+        quint32 mode;
+        QByteArray id;
+    };
+
+    bool readConfig();
+    bool resolveIdentity();
+    bool write(QFutureInterface<bool> &futureInterface);
+    bool writeRepositoryLayout();
+    bool checkIgnoredFiles();
+    bool writeObject(const QByteArray &type, const QByteArray &content, QByteArray *id);
+    bool writeTree(int begin, int end, int prefixLength, QByteArray *id);
+    bool writeIndex();
+    bool writeFile(const QString &relativePath, const QByteArray &content);
+    bool fail(const QString &message);
+
+    QString m_workingDirectory;
+    QString m_gitDir;
+    QStringList m_files;
+    QProcessEnvironment m_environment;
+    Utils::FileName m_gitBinary;
+
+    QHash<QString, QString> m_config;
+    QByteArray m_branch;
+    QByteArray m_author;
+    QByteArray m_committer;
+
+    QVector<IndexEntry> m_entries;
+    QByteArray m_commitId;
+    QString m_errorMessage;
+};
+
+} // namespace Internal
+} // namespace Milo
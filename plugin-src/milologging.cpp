@@ -0,0 +1,12 @@
+#include "milologging.h"
+
+namespace Milo {
+namespace Internal {
+
+Q_LOGGING_CATEGORY(projectTreeLog, "milo.wizard.projecttree", QtWarningMsg)
+Q_LOGGING_CATEGORY(fileListLog, "milo.wizard.filelist", QtWarningMsg)
+Q_LOGGING_CATEGORY(versionControlLog, "milo.wizard.versioncontrol", QtWarningMsg)
+Q_LOGGING_CATEGORY(pushQueueLog, "milo.wizard.pushqueue", QtWarningMsg)
+
+} // namespace Internal
+} // namespace Milo
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QLoggingCategory>
+
+namespace Milo {
+namespace Internal {
+
+// Timing output of the wizard phases. All categories are silent by default, enable them with
+// e.g. QT_LOGGING_RULES="milo.wizard.*.debug=true".
+Q_DECLARE_LOGGING_CATEGORY(projectTreeLog)
+Q_DECLARE_LOGGING_CATEGORY(fileListLog)
+Q_DECLARE_LOGGING_CATEGORY(versionControlLog)
+Q_DECLARE_LOGGING_CATEGORY(pushQueueLog)
+
+} // namespace Internal
+} // namespace Milo
@@ -1,5 +1,6 @@
 #include "miloplugin.h"
 #include "miloconstants.h"
+#include "milopushqueue.h"
 
 #include "gitclient.h"
 
@@ -37,6 +38,7 @@ MiloPlugin::~MiloPlugin()
 {
     // Unregister objects from the plugin manager's object pool
     // Delete members
+    delete m_pushQueue;
     delete m_gitClient;
 }
 
@@ -50,6 +52,11 @@ Git::Internal::GitClient *MiloPlugin::gitClient()
     return m_instance->m_gitClient;
 }
 
+PushQueue *MiloPlugin::pushQueue()
+{
+    return m_instance->m_pushQueue;
+}
+
 bool MiloPlugin::initialize(const QStringList &arguments, QString *errorString)
 {
     // Register objects in the plugin manager's object pool
@@ -63,6 +70,7 @@ bool MiloPlugin::initialize(const QStringList &arguments, QString *errorString)
     Q_UNUSED(errorString)
 
     m_gitClient = new GitClient;
+    m_pushQueue = new PushQueue;
 
     JsonWizardFactory::registerPageFactory(new SummaryPageFactory);
 
@@ -74,6 +82,9 @@ void MiloPlugin::extensionsInitialized()
     // Retrieve objects from the plugin manager's object pool
     // In the extensionsInitialized function, a plugin can be sure that all
     // plugins that depend on it are completely initialized.
+
+    // Resume pushes that did not finish in the previous session
+    m_pushQueue->restoreSettings(Core::ICore::settings());
 }
 
 ExtensionSystem::IPlugin::ShutdownFlag MiloPlugin::aboutToShutdown()
@@ -81,6 +92,7 @@ ExtensionSystem::IPlugin::ShutdownFlag MiloPlugin::aboutToShutdown()
     // Save settings
     // Disconnect from signals that are not needed during shutdown
     // Hide UI (if you add UI that is not in the main window directly)
+    m_pushQueue->saveSettings(Core::ICore::settings());
     return SynchronousShutdown;
 }
 
@@ -13,6 +13,8 @@ class GitClient;
 namespace Milo {
 namespace Internal {
 
+class PushQueue;
+
 class MiloPlugin : public ExtensionSystem::IPlugin
 {
     Q_OBJECT
@@ -24,13 +26,29 @@ public:
 
     static MiloPlugin *instance();
     static Git::Internal::GitClient *gitClient();
+    static PushQueue *pushQueue();
 
     bool initialize(const QStringList &arguments, QString *errorString) override;
     void extensionsInitialized() override;
     ShutdownFlag aboutToShutdown() override;
 
+#ifdef WITH_TESTS
+private slots:
+    void testGitPipeline();
+    void testGitPipelineFailure();
+    void testPushQueue();
+    void testPushQueueRetry();
+    void testPushQueueConcurrency();
+
+    void benchmarkSetFiles_data();
+    void benchmarkSetFiles();
+    void benchmarkRunVersionControl_data();
+    void benchmarkRunVersionControl();
+#endif
+
 private:
     Git::Internal::GitClient *m_gitClient = nullptr;
+    PushQueue *m_pushQueue = nullptr;
 };
 
 } // namespace Internal
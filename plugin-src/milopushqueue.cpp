@@ -0,0 +1,206 @@
+#include "milopushqueue.h"
+#include "milologging.h"
+#include "miloplugin.h"
+
+#include "gitclient.h"
+
+#include <coreplugin/icore.h>
+#include <utils/algorithm.h>
+#include <utils/qtcassert.h>
+#include <vcsbase/vcsoutputwindow.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QSharedPointer>
+
+using namespace Git::Internal;
+
+namespace Milo {
+namespace Internal {
+
+static const char SETTINGS_GROUP[] = "Milo/PushQueue";
+static const char KEY_JOBS[] = "Jobs";
+static const char KEY_WORKING_DIRECTORY[] = "WorkingDirectory";
+static const char KEY_REMOTE[] = "Remote";
+
+PushQueue::PushQueue(QObject *parent) : QObject(parent)
+{
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &PushQueue::startJobs);
+
+    // Running commands abort when Qt Creator closes, before the plugins shut down and save
+    // the queue. Such a push is neither canceled by the user nor failed, so keep it.
+    connect(Core::ICore::instance(), &Core::ICore::coreAboutToClose, this, [this]() {
+        m_shuttingDown = true;
+        m_retryTimer.stop();
+    });
+}
+
+void PushQueue::enqueue(const QString &workingDirectory, const QString &remote)
+{
+    Job job;
+    job.id = m_nextJobId++;
+    job.workingDirectory = workingDirectory;
+    job.remote = remote;
+    m_pending.append(job);
+    startJobs();
+}
+
+void PushQueue::setMaxConcurrentJobs(int count)
+{
+    m_maxConcurrentJobs = qMax(1, count);
+    startJobs();
+}
+
+void PushQueue::setMaxRetries(int retries)
+{
+    m_maxRetries = qMax(0, retries);
+}
+
+void PushQueue::setInitialRetryDelay(int milliseconds)
+{
+    m_initialRetryDelayMs = qMax(0, milliseconds);
+}
+
+// Running jobs are saved as well, they may not have finished aborting yet.
+void PushQueue::saveSettings(QSettings *settings) const
+{
+    QVariantList jobs;
+    for (const Job &job : m_running + m_pending) {
+        QVariantMap map;
+        map.insert(QLatin1String(KEY_WORKING_DIRECTORY), job.workingDirectory);
+        map.insert(QLatin1String(KEY_REMOTE), job.remote);
+        jobs.append(map);
+    }
+    settings->beginGroup(QLatin1String(SETTINGS_GROUP));
+    settings->setValue(QLatin1String(KEY_JOBS), jobs);
+    settings->endGroup();
+}
+
+void PushQueue::restoreSettings(QSettings *settings)
+{
+    settings->beginGroup(QLatin1String(SETTINGS_GROUP));
+    const QVariantList jobs = settings->value(QLatin1String(KEY_JOBS)).toList();
+    settings->endGroup();
+
+    for (const QVariant &job : jobs) {
+        const QVariantMap map = job.toMap();
+        const QString workingDirectory = map.value(QLatin1String(KEY_WORKING_DIRECTORY)).toString();
+        if (QFileInfo(workingDirectory).isDir())
+            enqueue(workingDirectory, map.value(QLatin1String(KEY_REMOTE), QString("origin")).toString());
+    }
+}
+
+// Reads the branch HEAD points to without spawning git. Returns an empty string
+// for a detached HEAD or if the repository cannot be read.
+QString PushQueue::currentBranch(const QString &workingDirectory)
+{
+    QString gitDir = workingDirectory + "/.git";
+    if (QFileInfo(gitDir).isFile()) {
+        // Worktrees and submodules have a ".git" file pointing to the actual directory.
+        QFile file(gitDir);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return QString();
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (!line.startsWith("gitdir:"))
+            return QString();
+        gitDir = QDir(workingDirectory).absoluteFilePath(line.mid(7).trimmed());
+    }
+
+    QFile head(gitDir + "/HEAD");
+    if (!head.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QString();
+    const QString ref = QString::fromUtf8(head.readLine()).trimmed();
+    const QString prefix = "ref: refs/heads/";
+    return ref.startsWith(prefix) ? ref.mid(prefix.size()) : QString();
+}
+
+void PushQueue::startJobs()
+{
+    if (m_shuttingDown)
+        return;
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (int i = 0; i < m_pending.size() && m_running.size() < m_maxConcurrentJobs; ) {
+        if (m_pending.at(i).notBefore.isValid() && m_pending.at(i).notBefore > now) {
+            ++i;
+            continue;
+        }
+        const Job job = m_pending.takeAt(i);
+        m_running.append(job);
+        startJob(job);
+    }
+
+    // Wake up again for the earliest job that waits for its retry.
+    QDateTime next;
+    for (const Job &job : m_pending) {
+        if (job.notBefore > now && (!next.isValid() || job.notBefore < next))
+            next = job.notBefore;
+    }
+    if (next.isValid())
+        m_retryTimer.start(int(qMax<qint64>(0, now.msecsTo(next))));
+}
+
+void PushQueue::startJob(const Job &job)
+{
+    GitClient *git = MiloPlugin::gitClient();
+    QTC_ASSERT(git, finishJob(job, false, true); return);
+
+    // Push whatever branch the repository is on, HEAD if that cannot be determined.
+    const QString branch = currentBranch(job.workingDirectory);
+    const QString refspec = branch.isEmpty() ? QString("HEAD") : branch;
+
+    GitCommandRunner *command = git->createCommandRunner(
+                job.workingDirectory,
+                tr("Push %1").arg(QDir(job.workingDirectory).dirName()));
+    command->addGitJob({"push", "-u", job.remote, refspec});
+    connect(command, &GitCommandRunner::jobFinished,
+            [job](const QStringList &, bool success, qint64 elapsedMs) {
+        qCDebug(pushQueueLog) << "Push of" << job.workingDirectory << "attempt" << job.attempts + 1
+                              << (success ? "succeeded" : "failed") << "in" << elapsedMs << "ms";
+    });
+
+    // Canceling from the progress indicator terminates the command. Do not retry then.
+    auto canceled = QSharedPointer<bool>::create(false);
+    connect(command, &VcsBase::VcsCommand::terminate, this, [canceled]() { *canceled = true; });
+    connect(command, &VcsBase::VcsCommand::finished,
+            this, [this, job, canceled](bool ok, int, const QVariant &) {
+        finishJob(job, ok, *canceled);
+    });
+    command->execute();
+}
+
+void PushQueue::finishJob(Job job, bool success, bool canceled)
+{
+    const int id = job.id;
+    m_running = Utils::filtered(m_running, [id](const Job &j) { return j.id != id; });
+
+    if (m_shuttingDown && !success) {
+        job.notBefore = QDateTime();
+        m_pending.append(job);
+        return;
+    }
+
+    ++job.attempts;
+    if (!success && !canceled && job.attempts <= m_maxRetries) {
+        const qint64 delay = qint64(m_initialRetryDelayMs) << (job.attempts - 1);
+        job.notBefore = QDateTime::currentDateTimeUtc().addMSecs(delay);
+        VcsBase::VcsOutputWindow::appendWarning(
+                    tr("Pushing \"%1\" failed, retrying in %n second(s).", nullptr, int(delay / 1000))
+                    .arg(QDir::toNativeSeparators(job.workingDirectory)));
+        m_pending.append(job);
+    } else {
+        if (!success) {
+            VcsBase::VcsOutputWindow::appendError(
+                        tr("Failed to push \"%1\" to \"%2\".")
+                        .arg(QDir::toNativeSeparators(job.workingDirectory), job.remote));
+        }
+        emit jobFinished(job.workingDirectory, success);
+    }
+    startJobs();
+}
+
+} // namespace Internal
+} // namespace Milo
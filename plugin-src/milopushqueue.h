@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+QT_BEGIN_NAMESPACE
+class QSettings;
+QT_END_NAMESPACE
+
+namespace Milo {
+namespace Internal {
+
+// Pushes repositories to their remotes in the background, independently of the wizard that
+// requested it. At most maxConcurrentJobs() pushes run at a time, failed pushes are retried
+// with exponential backoff, and jobs that did not finish are kept across sessions.
+class PushQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PushQueue(QObject *parent = nullptr);
+
+    void enqueue(const QString &workingDirectory, const QString &remote = QLatin1String("origin"));
+
+    int maxConcurrentJobs() const { return m_maxConcurrentJobs; }
+    void setMaxConcurrentJobs(int count);
+    int maxRetries() const { return m_maxRetries; }
+    void setMaxRetries(int retries);
+    int initialRetryDelay() const { return m_initialRetryDelayMs; }
+    void setInitialRetryDelay(int milliseconds);
+
+    int pendingCount() const { return m_pending.size(); }
+    int runningCount() const { return m_running.size(); }
+
+    void saveSettings(QSettings *settings) const;
+    void restoreSettings(QSettings *settings);
+
+    static QString currentBranch(const QString &workingDirectory);
+
+signals:
+    void jobFinished(const QString &workingDirectory, bool success);
+
+private:
+    struct Job
+    {
+        int id = 0;
+        QString workingDirectory;
+        QString remote;
+        int attempts = 0;
+        QDateTime notBefore;
+    };
+
+    void startJobs();
+    void startJob(const Job &job);
+    void finishJob(Job job, bool success, bool canceled);
+
+    QList<Job> m_pending;
+    QList<Job> m_running;
+    QTimer m_retryTimer;
+    bool m_shuttingDown = false;
+    int m_nextJobId = 1;
+    int m_maxConcurrentJobs = 2;
+    int m_maxRetries = 4;
+    int m_initialRetryDelayMs = 2000;
+};
+
+} // namespace Internal
+} // namespace Milo
@@ -0,0 +1,132 @@
+#include "miloplugin.h"
+#include "milopushqueue.h"
+#include "milotestutils.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QSharedPointer>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QtTest>
+
+using namespace Milo::Internal::Tests;
+
+namespace Milo {
+namespace Internal {
+
+// A repository with one commit on the given branch, and "origin" pointing to remoteUrl.
+static bool createRepository(const QString &path, const QString &branch, const QString &remoteUrl)
+{
+    return runGit(path, {"init"})
+            && runGit(path, {"symbolic-ref", "HEAD", "refs/heads/" + branch})
+            && writeFile(path + "/main.cpp", "int main() { return 0; }\n")
+            && runGit(path, {"add", "main.cpp"})
+            && runGit(path, {"commit", "-m", "Initial commit"})
+            && runGit(path, {"remote", "add", "origin", remoteUrl});
+}
+
+// The queue pushes the branch .git/HEAD points to, whatever its name.
+void MiloPlugin::testPushQueue()
+{
+    const GitIdentity identity;
+    QTemporaryDir remote;
+    QTemporaryDir project;
+    QVERIFY(remote.isValid());
+    QVERIFY(project.isValid());
+    QVERIFY(runGit(remote.path(), {"init", "--bare"}));
+    QVERIFY(createRepository(project.path(), "develop",
+                             QUrl::fromLocalFile(remote.path()).toString()));
+    QCOMPARE(PushQueue::currentBranch(project.path()), QString("develop"));
+
+    PushQueue queue;
+    QSignalSpy finished(&queue, &PushQueue::jobFinished);
+    queue.enqueue(project.path());
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.first().at(0).toString(), project.path());
+    QVERIFY(finished.first().at(1).toBool());
+    QCOMPARE(queue.pendingCount(), 0);
+    QCOMPARE(queue.runningCount(), 0);
+
+    QString output;
+    QVERIFY(runGit(remote.path(), {"for-each-ref", "--format=%(refname)", "refs/heads"}, &output));
+    QCOMPARE(output.trimmed(), QString("refs/heads/develop"));
+    QVERIFY(runGit(project.path(), {"rev-parse", "--abbrev-ref", "develop@{upstream}"}, &output));
+    QCOMPARE(output.trimmed(), QString("origin/develop"));
+    QVERIFY(!QApplication::activeModalWidget());
+}
+
+// A push to a remote that does not exist is retried maxRetries() times, then reported
+// as failed in the output pane.
+void MiloPlugin::testPushQueueRetry()
+{
+    const GitIdentity identity;
+    QTemporaryDir project;
+    QVERIFY(project.isValid());
+    const QString unreachable = QUrl::fromLocalFile(project.path() + "/missing.git").toString();
+    QVERIFY(createRepository(project.path(), "master", unreachable));
+
+    PushQueue queue;
+    queue.setInitialRetryDelay(0);
+    queue.setMaxRetries(2);
+    QSignalSpy finished(&queue, &PushQueue::jobFinished);
+    queue.enqueue(project.path());
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.size(), 1);
+    QVERIFY(!finished.first().at(1).toBool());
+    QCOMPARE(queue.pendingCount(), 0);
+    QCOMPARE(queue.runningCount(), 0);
+
+    const QString directory = QDir::toNativeSeparators(project.path());
+    const QString output = versionControlOutput();
+    QCOMPARE(output.count(QString("Pushing \"%1\" failed, retrying").arg(directory)), 2);
+    QVERIFY(output.contains(QString("Failed to push \"%1\" to \"origin\".").arg(directory)));
+    QVERIFY(!QApplication::activeModalWidget());
+}
+
+// No more than maxConcurrentJobs() pushes run at a time, the others wait for their turn.
+void MiloPlugin::testPushQueueConcurrency()
+{
+    const GitIdentity identity;
+    const int jobCount = 4;
+    QList<QSharedPointer<QTemporaryDir>> remotes;
+    QList<QSharedPointer<QTemporaryDir>> projects;
+    for (int i = 0; i < jobCount; ++i) {
+        remotes << QSharedPointer<QTemporaryDir>::create();
+        projects << QSharedPointer<QTemporaryDir>::create();
+        QVERIFY(remotes.last()->isValid());
+        QVERIFY(projects.last()->isValid());
+        QVERIFY(runGit(remotes.last()->path(), {"init", "--bare"}));
+        QVERIFY(createRepository(projects.last()->path(), "master",
+                                 QUrl::fromLocalFile(remotes.last()->path()).toString()));
+    }
+
+    PushQueue queue;
+    queue.setMaxConcurrentJobs(1);
+    QSignalSpy finished(&queue, &PushQueue::jobFinished);
+    for (const QSharedPointer<QTemporaryDir> &project : projects)
+        queue.enqueue(project->path());
+    QCOMPARE(queue.runningCount(), 1);
+    QCOMPARE(queue.pendingCount(), jobCount - 1);
+
+    while (finished.size() < jobCount) {
+        QVERIFY(finished.wait(30000));
+        QVERIFY(queue.runningCount() <= 1);
+        QCOMPARE(queue.runningCount() + queue.pendingCount(), jobCount - finished.size());
+    }
+    for (const QList<QVariant> &arguments : finished)
+        QVERIFY(arguments.at(1).toBool());
+
+    // Raising the limit starts waiting jobs right away.
+    for (const QSharedPointer<QTemporaryDir> &project : projects)
+        queue.enqueue(project->path());
+    QCOMPARE(queue.runningCount(), 1);
+    queue.setMaxConcurrentJobs(3);
+    QCOMPARE(queue.runningCount(), 3);
+    QCOMPARE(queue.pendingCount(), jobCount - 3);
+    while (finished.size() < 2 * jobCount)
+        QVERIFY(finished.wait(30000));
+}
+
+} // namespace Internal
+} // namespace Milo
@@ -0,0 +1,78 @@
+#include "milotestutils.h"
+#include "miloplugin.h"
+
+#include "gitclient.h"
+
+#include <vcsbase/vcsoutputwindow.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPlainTextEdit>
+#include <QProcess>
+
+using namespace Git::Internal;
+
+namespace Milo {
+namespace Internal {
+namespace Tests {
+
+static const char *const identityVariables[] = {
+    "GIT_AUTHOR_NAME", "GIT_AUTHOR_EMAIL", "GIT_COMMITTER_NAME", "GIT_COMMITTER_EMAIL"
+};
+
+bool runGit(const QString &workingDirectory, const QStringList &arguments, QString *output)
+{
+    GitClient *git = MiloPlugin::gitClient();
+    QProcess process;
+    process.setWorkingDirectory(workingDirectory);
+    process.setProcessEnvironment(git->processEnvironment());
+    process.start(git->vcsBinary().toString(), arguments);
+    if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit)
+        return false;
+    if (output)
+        *output = QString::fromUtf8(process.readAllStandardOutput());
+    return process.exitCode() == 0;
+}
+
+bool writeFile(const QString &filePath, const QByteArray &content)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+QString versionControlOutput()
+{
+    auto edit = qobject_cast<QPlainTextEdit *>(
+                VcsBase::VcsOutputWindow::instance()->outputWidget(nullptr));
+    return edit ? edit->toPlainText() : QString();
+}
+
+GitIdentity::GitIdentity()
+{
+    for (const char *variable : identityVariables) {
+        if (qEnvironmentVariableIsSet(variable))
+            m_previousValues.insert(variable, qgetenv(variable));
+    }
+    qputenv("GIT_AUTHOR_NAME", "Milo Test");
+    qputenv("GIT_AUTHOR_EMAIL", "milo.test@example.com");
+    qputenv("GIT_COMMITTER_NAME", "Milo Test");
+    qputenv("GIT_COMMITTER_EMAIL", "milo.test@example.com");
+    MiloPlugin::gitClient()->reloadSettings();
+}
+
+GitIdentity::~GitIdentity()
+{
+    for (const char *variable : identityVariables) {
+        if (m_previousValues.contains(variable))
+            qputenv(variable, m_previousValues.value(variable));
+        else
+            qunsetenv(variable);
+    }
+    MiloPlugin::gitClient()->reloadSettings();
+}
+
+} // namespace Tests
+} // namespace Internal
+} // namespace Milo
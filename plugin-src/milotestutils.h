@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+
+namespace Milo {
+namespace Internal {
+namespace Tests {
+
+// Runs git synchronously with the binary and environment of the plugin's GitClient.
+bool runGit(const QString &workingDirectory, const QStringList &arguments,
+            QString *output = nullptr);
+
+bool writeFile(const QString &filePath, const QByteArray &content);
+
+// Text of the Version Control output pane.
+QString versionControlOutput();
+
+// Gives git a commit identity for as long as it exists, whatever the user configured.
+class GitIdentity
+{
+public:
+    GitIdentity();
+    ~GitIdentity();
+
+private:
+    QHash<QByteArray, QByteArray> m_previousValues;
+};
+
+} // namespace Tests
+} // namespace Internal
+} // namespace Milo
@@ -0,0 +1,165 @@
+#include "miloplugin.h"
+#include "miloconstants.h"
+#include "milotestutils.h"
+
+#include "projectwizardpage.h"
+
+#include <coreplugin/icore.h>
+#include <coreplugin/iversioncontrol.h>
+#include <coreplugin/vcsmanager.h>
+#include <utils/algorithm.h>
+#include <vcsbase/vcsbaseconstants.h>
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDir>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace Core;
+using namespace Milo::Internal::Tests;
+using namespace ProjectExplorer::Internal;
+
+namespace Milo {
+namespace Internal {
+
+// Files in directories of ten files each, two levels below the given directory.
+static QStringList generatedFilePaths(const QString &directory, int count)
+{
+    QStringList files;
+    files.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        files << directory + QString("/src%1/module%2/file%3.cpp")
+                 .arg(i / 1000).arg(i / 10 % 100).arg(i);
+    }
+    return files;
+}
+
+// Sets a value in the Qt Creator settings for as long as it lives, whatever way the test
+// function is left.
+class SettingsValueGuard
+{
+public:
+    SettingsValueGuard(const QString &key, const QVariant &value) :
+        m_key(key),
+        m_previousValue(ICore::settings()->value(key))
+    {
+        ICore::settings()->setValue(key, value);
+    }
+
+    ~SettingsValueGuard()
+    {
+        if (m_previousValue.isValid())
+            ICore::settings()->setValue(m_key, m_previousValue);
+        else
+            ICore::settings()->remove(m_key);
+    }
+
+private:
+    const QString m_key;
+    const QVariant m_previousValue;
+};
+
+void MiloPlugin::benchmarkSetFiles_data()
+{
+    QTest::addColumn<int>("fileCount");
+    QTest::addColumn<bool>("groupByDirectory");
+
+    for (int fileCount : {10, 100, 1000, 10000}) {
+        QTest::newRow(qPrintable(QString("%1 files").arg(fileCount))) << fileCount << false;
+        QTest::newRow(qPrintable(QString("%1 files, grouped").arg(fileCount))) << fileCount << true;
+    }
+}
+
+void MiloPlugin::benchmarkSetFiles()
+{
+    // The benchmarks take minutes, they only run on request.
+    if (!qEnvironmentVariableIsSet("MILO_BENCHMARK"))
+        QSKIP("Set MILO_BENCHMARK to run the benchmarks.");
+    QFETCH(int, fileCount);
+    QFETCH(bool, groupByDirectory);
+
+    ProjectWizardPage page;
+    page.findChild<QCheckBox *>("groupByDirectoryCheckBox")->setChecked(groupByDirectory);
+    const QStringList files = generatedFilePaths(QDir::tempPath() + "/milo-benchmark", fileCount);
+
+    QBENCHMARK {
+        // The page skips a file list it already shows.
+        page.setFiles(QStringList());
+        page.setFiles(files);
+    }
+}
+
+void MiloPlugin::benchmarkRunVersionControl_data()
+{
+    QTest::addColumn<int>("fileCount");
+    QTest::addColumn<bool>("initialCommit");
+    QTest::addColumn<bool>("inProcessInitialCommit");
+
+    for (int fileCount : {10, 100, 1000, 10000}) {
+        const QString files = QString("%1 files").arg(fileCount);
+        QTest::newRow(qPrintable(files + ", add")) << fileCount << false << false;
+        QTest::newRow(qPrintable(files + ", commit")) << fileCount << true << false;
+        QTest::newRow(qPrintable(files + ", in-process commit")) << fileCount << true << true;
+    }
+}
+
+// From runVersionControl() until the version control state of the directory is reset,
+// which is the last thing the git steps do.
+void MiloPlugin::benchmarkRunVersionControl()
+{
+    // The benchmarks take minutes, they only run on request.
+    if (!qEnvironmentVariableIsSet("MILO_BENCHMARK"))
+        QSKIP("Set MILO_BENCHMARK to run the benchmarks.");
+    QFETCH(int, fileCount);
+    QFETCH(bool, initialCommit);
+    QFETCH(bool, inProcessInitialCommit);
+
+    const GitIdentity identity;
+    QTemporaryDir project;
+    QVERIFY(project.isValid());
+    const QStringList paths = generatedFilePaths(project.path(), fileCount);
+    QList<GeneratedFile> files;
+    for (const QString &path : paths) {
+        QVERIFY(writeFile(path, path.toUtf8()));
+        files << GeneratedFile(path);
+    }
+
+    ProjectWizardPage page;
+    page.setFiles(paths);
+    page.initializeVersionControls();
+    auto versionControls = page.findChild<QComboBox *>("addToVersionControlComboBox");
+    for (int i = 1; i < versionControls->count(); ++i) {
+        page.setVersionControlIndex(i);
+        if (page.currentVersionControl()->id() == Id(VcsBase::Constants::VCS_ID_GIT))
+            break;
+    }
+    QVERIFY(page.currentVersionControl());
+    QCOMPARE(page.currentVersionControl()->id(), Id(VcsBase::Constants::VCS_ID_GIT));
+    page.findChild<QCheckBox *>("initialCommitCheckBox")->setChecked(initialCommit);
+
+    const SettingsValueGuard inProcessSetting(QLatin1String(Constants::IN_PROCESS_INITIAL_COMMIT_KEY),
+                                              inProcessInitialCommit);
+
+    const QString directory = QDir(project.path()).absolutePath();
+    QSignalSpy repositoryChanged(VcsManager::instance(), &VcsManager::repositoryChanged);
+    QString errorMessage;
+    QBENCHMARK_ONCE {
+        QVERIFY2(page.runVersionControl(files, &errorMessage), qPrintable(errorMessage));
+        while (!Utils::contains(repositoryChanged, [directory](const QList<QVariant> &arguments) {
+                   return arguments.at(0).toString() == directory;
+               })) {
+            QVERIFY(repositoryChanged.wait(300000));
+        }
+    }
+
+    QString output;
+    QVERIFY(runGit(project.path(), {"ls-files"}, &output));
+    QCOMPARE(output.split('\n', QString::SkipEmptyParts).size(), fileCount);
+    QCOMPARE(runGit(project.path(), {"rev-parse", "--verify", "--quiet", "HEAD"}), initialCommit);
+}
+
+} // namespace Internal
+} // namespace Milo
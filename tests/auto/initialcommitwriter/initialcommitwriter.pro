@@ -0,0 +1,8 @@
+QTC_LIB_DEPENDS += utils
+
+include(../../milotest.pri)
+
+SOURCES += tst_initialcommitwriter.cpp \
+    $$MILO_SOURCE_TREE/miloinitialcommitwriter.cpp
+
+HEADERS += $$MILO_SOURCE_TREE/miloinitialcommitwriter.h
@@ -0,0 +1,267 @@
+#include "miloinitialcommitwriter.h"
+
+#include <utils/hostosinfo.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <memory>
+
+using namespace Milo::Internal;
+using namespace Utils;
+
+class tst_InitialCommitWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void commit_data();
+    void commit();
+    void refuse_data();
+    void refuse();
+    void ignoredFile();
+
+private:
+    bool runGit(const QString &workingDirectory, const QStringList &arguments,
+                QString *output = nullptr) const;
+    bool runWriter(InitialCommitWriter &writer) const;
+    QStringList writeFiles(const QString &directory, const QStringList &relativePaths) const;
+
+    QString m_git;
+    std::unique_ptr<QTemporaryDir> m_home;
+    QProcessEnvironment m_environment;
+};
+
+static bool writeFile(const QString &filePath, const QByteArray &content)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+void tst_InitialCommitWriter::initTestCase()
+{
+    m_git = QStandardPaths::findExecutable("git");
+    QVERIFY2(!m_git.isEmpty(), "git needs to be in PATH.");
+}
+
+// Every test gets a user configuration of its own, and nothing from the system or the
+// environment of the user running the tests.
+void tst_InitialCommitWriter::init()
+{
+    m_home.reset(new QTemporaryDir);
+    QVERIFY(m_home->isValid());
+    QVERIFY(writeFile(m_home->path() + "/.gitconfig",
+                      "[user]\n"
+                      "\tname = Milo Test\n"
+                      "\temail = milo.test@example.com\n"));
+
+    m_environment = QProcessEnvironment::systemEnvironment();
+    for (const QString &key : m_environment.keys()) {
+        if (key.startsWith("GIT_") || key == "EMAIL")
+            m_environment.remove(key);
+    }
+    m_environment.insert("HOME", m_home->path());
+    m_environment.insert("XDG_CONFIG_HOME", m_home->path() + "/.config");
+    m_environment.insert("GIT_CONFIG_NOSYSTEM", "1");
+}
+
+void tst_InitialCommitWriter::cleanup()
+{
+    m_home.reset();
+}
+
+void tst_InitialCommitWriter::commit_data()
+{
+    QTest::addColumn<QStringList>("files");
+    QTest::addColumn<QStringList>("executableFiles");
+
+    QTest::newRow("single file")
+            << QStringList({"main.cpp"}) << QStringList();
+    QTest::newRow("nested directories")
+            << QStringList({"main.cpp", "src/app/app.cpp", "src/app/app.h", "src/lib/lib.cpp",
+                            "src/lib/detail/impl.cpp", "doc/readme.txt"})
+            << QStringList();
+    // Trees sort directories as if their names ended with '/', which sorts after '.' and '-'
+    // but before '0'. The index sorts the full paths.
+    QTest::newRow("dot and slash")
+            << QStringList({"a.txt", "a/b", "a-c/d", "a0", "a/b.c/d", "a/b-c"})
+            << QStringList();
+    if (!HostOsInfo::isWindowsHost()) {
+        QTest::newRow("executable files")
+                << QStringList({"configure", "main.cpp", "scripts/build.sh"})
+                << QStringList({"configure", "scripts/build.sh"});
+    }
+}
+
+// The writer's repository must pass git's own checks and hold the same tree that
+// the git command line creates for the same files.
+void tst_InitialCommitWriter::commit()
+{
+    QFETCH(QStringList, files);
+    QFETCH(QStringList, executableFiles);
+
+    QTemporaryDir project;
+    QVERIFY(project.isValid());
+    const QStringList filePaths = writeFiles(project.path(), files);
+    QCOMPARE(filePaths.size(), files.size());
+    for (const QString &file : executableFiles) {
+        QFile f(project.path() + '/' + file);
+        QVERIFY(f.setPermissions(f.permissions() | QFile::ExeOwner | QFile::ExeUser
+                                 | QFile::ExeGroup | QFile::ExeOther));
+    }
+
+    InitialCommitWriter writer(project.path(), filePaths, m_environment, FileName::fromString(m_git));
+    QString reason;
+    QVERIFY2(writer.canWrite(&reason), qPrintable(reason));
+    QVERIFY2(runWriter(writer), qPrintable(writer.errorMessage()));
+
+    QString output;
+    QVERIFY(runGit(project.path(), {"fsck", "--strict", "--no-progress", "--no-dangling"}, &output));
+    QCOMPARE(output, QString());
+    QVERIFY(runGit(project.path(), {"status", "--porcelain", "--untracked-files=all"}, &output));
+    QCOMPARE(output, QString());
+    QVERIFY(runGit(project.path(), {"log", "--format=%H %s"}, &output));
+    QCOMPARE(output, QString::fromLatin1(writer.commitId().toHex()) + " Initial commit\n");
+
+    QString tree;
+    QVERIFY(runGit(project.path(), {"log", "--format=%T"}, &tree));
+    QString index;
+    QVERIFY(runGit(project.path(), {"ls-files", "--stage"}, &index));
+
+    // The same with the git command line.
+    QTemporaryDir reference;
+    QVERIFY(reference.isValid());
+    writeFiles(reference.path(), files);
+    for (const QString &file : executableFiles) {
+        QFile f(reference.path() + '/' + file);
+        QVERIFY(f.setPermissions(f.permissions() | QFile::ExeOwner | QFile::ExeUser
+                                 | QFile::ExeGroup | QFile::ExeOther));
+    }
+    QVERIFY(runGit(reference.path(), {"init"}));
+    QVERIFY(runGit(reference.path(), QStringList({"add", "--"}) + files));
+    QVERIFY(runGit(reference.path(), {"commit", "-m", "Initial commit"}));
+
+    QVERIFY(runGit(reference.path(), {"log", "--format=%T"}, &output));
+    QCOMPARE(tree, output);
+    QVERIFY(runGit(reference.path(), {"ls-files", "--stage"}, &output));
+    QCOMPARE(index, output);
+}
+
+void tst_InitialCommitWriter::refuse_data()
+{
+    QTest::addColumn<QByteArray>("config");
+    QTest::addColumn<QStringList>("files");
+
+    QTest::newRow("hooks path")
+            << QByteArray("[core]\n\thooksPath = hooks\n") << QStringList({"main.cpp"});
+    QTest::newRow("hooks path after the section header")
+            << QByteArray("[core] hooksPath = hooks\n") << QStringList({"main.cpp"});
+    QTest::newRow("commit signing")
+            << QByteArray("[commit]\n\tgpgSign = true\n") << QStringList({"main.cpp"});
+    QTest::newRow("commit signing after the section header")
+            << QByteArray("[commit] gpgsign = true\n") << QStringList({"main.cpp"});
+    QTest::newRow("continued line")
+            << QByteArray("[core]\n\thooksPath = \\\nhooks\n") << QStringList({"main.cpp"});
+    QTest::newRow("conditional include")
+            << QByteArray("[includeIf \"gitdir:~/\"]\n\tpath = other.gitconfig\n")
+            << QStringList({"main.cpp"});
+    QTest::newRow("attributes")
+            << QByteArray() << QStringList({"main.cpp", "src/.gitattributes"});
+}
+
+// Whatever the writer does not handle itself is left to git.
+void tst_InitialCommitWriter::refuse()
+{
+    QFETCH(QByteArray, config);
+    QFETCH(QStringList, files);
+
+    QFile gitConfig(m_home->path() + "/.gitconfig");
+    QVERIFY(gitConfig.open(QIODevice::Append));
+    gitConfig.write(config);
+    gitConfig.close();
+
+    QTemporaryDir project;
+    QVERIFY(project.isValid());
+    const QStringList filePaths = writeFiles(project.path(), files);
+
+    InitialCommitWriter writer(project.path(), filePaths, m_environment, FileName::fromString(m_git));
+    // The files are checked up front, the configuration when the writer runs.
+    QString reason;
+    if (writer.canWrite(&reason)) {
+        QVERIFY(!runWriter(writer));
+        QVERIFY(!writer.errorMessage().isEmpty());
+    } else {
+        QVERIFY(!reason.isEmpty());
+    }
+    QVERIFY(!QFileInfo::exists(project.path() + "/.git"));
+}
+
+// "git add" refuses ignored files, the writer must not commit them either.
+void tst_InitialCommitWriter::ignoredFile()
+{
+    QTemporaryDir project;
+    QVERIFY(project.isValid());
+    const QStringList filePaths = writeFiles(project.path(), {"main.cpp", "build/output.log"});
+    QVERIFY(writeFile(project.path() + "/.gitignore", "*.log\n"));
+
+    InitialCommitWriter writer(project.path(), filePaths + QStringList(project.path() + "/.gitignore"),
+                               m_environment, FileName::fromString(m_git));
+    QString reason;
+    QVERIFY2(writer.canWrite(&reason), qPrintable(reason));
+    QVERIFY(!runWriter(writer));
+    QVERIFY(writer.errorMessage().contains(
+                QDir::toNativeSeparators(project.path() + "/build/output.log")));
+    QVERIFY(!QFileInfo::exists(project.path() + "/.git"));
+}
+
+bool tst_InitialCommitWriter::runGit(const QString &workingDirectory, const QStringList &arguments,
+                                     QString *output) const
+{
+    QProcess process;
+    process.setWorkingDirectory(workingDirectory);
+    process.setProcessEnvironment(m_environment);
+    process.start(m_git, arguments);
+    if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit)
+        return false;
+    if (output) {
+        *output = QString::fromUtf8(process.readAllStandardOutput())
+                + QString::fromUtf8(process.readAllStandardError());
+    }
+    return process.exitCode() == 0;
+}
+
+bool tst_InitialCommitWriter::runWriter(InitialCommitWriter &writer) const
+{
+    QFutureInterface<bool> futureInterface;
+    futureInterface.reportStarted();
+    writer.run(futureInterface);
+    futureInterface.reportFinished();
+    return futureInterface.future().result();
+}
+
+// Writes the files with their own path as content, and returns their absolute paths.
+QStringList tst_InitialCommitWriter::writeFiles(const QString &directory,
+                                                const QStringList &relativePaths) const
+{
+    QStringList filePaths;
+    for (const QString &relativePath : relativePaths) {
+        const QString filePath = directory + '/' + relativePath;
+        if (writeFile(filePath, relativePath.toUtf8() + '\n'))
+            filePaths << filePath;
+    }
+    return filePaths;
+}
+
+QTEST_GUILESS_MAIN(tst_InitialCommitWriter)
+
+#include "tst_initialcommitwriter.moc"
@@ -0,0 +1,11 @@
+CONFIG += benchmark
+
+QTC_LIB_DEPENDS += utils
+QTC_PLUGIN_DEPENDS += projectexplorer
+
+include(../../milotest.pri)
+
+SOURCES += tst_projecttree.cpp \
+    $$MILO_SOURCE_TREE/external/projectexplorer/addnewtree.cpp
+
+HEADERS += $$MILO_SOURCE_TREE/external/projectexplorer/addnewtree.h
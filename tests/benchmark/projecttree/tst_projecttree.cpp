@@ -0,0 +1,192 @@
+#include "addnewtree.h"
+
+#include <projectexplorer/projectnodes.h>
+#include <utils/fileutils.h>
+
+#include <QtTest>
+
+#include <memory>
+
+using namespace ProjectExplorer;
+using namespace ProjectExplorer::Internal;
+using namespace Utils;
+
+// A project that accepts new files and sub-projects, like the qmake and CMake projects do.
+class BenchmarkProjectNode : public ProjectNode
+{
+public:
+    explicit BenchmarkProjectNode(const QString &directory) :
+        ProjectNode(FileName::fromString(directory + "/project.pro"))
+    {
+        setDisplayName(FileName::fromString(directory).fileName());
+    }
+
+    bool supportsAction(ProjectAction action, Node *) const override
+    {
+        return action == AddNewFile || action == AddSubProject;
+    }
+
+    bool canAddSubProject(const QString &) const override { return true; }
+};
+
+// A synthetic session: a tree of folderCount folder nodes with a fan-out of eight, every
+// projectInterval-th of them a project. Projects are children of projects, as sub-projects
+// are in qmake trees. Nothing of it exists on disk.
+struct Session
+{
+    std::unique_ptr<ProjectNode> root;
+    ProjectNode *lastProject = nullptr;
+};
+
+static Session createSession(int folderCount, int projectInterval = 50)
+{
+    Session session;
+    session.root.reset(new BenchmarkProjectNode("/session"));
+    session.lastProject = session.root.get();
+
+    QVector<FolderNode *> folders = {session.root.get()};
+    QVector<int> parents = {-1};
+    QStringList directories = {"/session"};
+    folders.reserve(folderCount);
+    parents.reserve(folderCount);
+    directories.reserve(folderCount);
+    while (folders.size() < folderCount) {
+        int parent = (folders.size() - 1) / 8;
+        FolderNode *folder;
+        if (folders.size() % projectInterval == 0) {
+            while (folders.at(parent)->nodeType() != NodeType::Project)
+                parent = parents.at(parent);
+            directories.append(directories.at(parent) + QString("/dir%1").arg(folders.size()));
+            session.lastProject = new BenchmarkProjectNode(directories.last());
+            folder = session.lastProject;
+        } else {
+            directories.append(directories.at(parent) + QString("/dir%1").arg(folders.size()));
+            folder = new FolderNode(FileName::fromString(directories.last()));
+        }
+        folders.at(parent)->addNode(folder);
+        folders.append(folder);
+        parents.append(parent);
+    }
+    return session;
+}
+
+// New files in a sub-directory of the project created last.
+static QStringList createFiles(const Session &session, int count)
+{
+    const QString directory = session.lastProject->filePath().parentDir().toString() + "/new";
+    QStringList files;
+    files.reserve(count);
+    for (int i = 0; i < count; ++i)
+        files << directory + QString("/file%1.cpp").arg(i);
+    return files;
+}
+
+class tst_ProjectTree : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void buildAddFilesTree_data();
+    void buildAddFilesTree();
+    void buildAddProjectTree_data();
+    void buildAddProjectTree();
+    void bestNodeSelector_data();
+    void bestNodeSelector();
+
+private:
+    void addSessionRows();
+};
+
+void tst_ProjectTree::addSessionRows()
+{
+    QTest::addColumn<int>("folderCount");
+    QTest::addColumn<int>("fileCount");
+
+    QTest::newRow("1k folders, 10 files") << 1000 << 10;
+    QTest::newRow("10k folders, 100 files") << 10000 << 100;
+    QTest::newRow("10k folders, 10k files") << 10000 << 10000;
+    QTest::newRow("100k folders, 1k files") << 100000 << 1000;
+    QTest::newRow("100k folders, 10k files") << 100000 << 10000;
+}
+
+void tst_ProjectTree::buildAddFilesTree_data()
+{
+    addSessionRows();
+}
+
+void tst_ProjectTree::buildAddFilesTree()
+{
+    QFETCH(int, folderCount);
+    QFETCH(int, fileCount);
+
+    const Session session = createSession(folderCount);
+    const QStringList files = createFiles(session, fileCount);
+    const QString commonDirectory = FileName::fromString(files.first()).parentDir().toString();
+
+    QBENCHMARK {
+        BestNodeSelector selector(commonDirectory, files);
+        std::unique_ptr<AddNewTree> tree(
+                    ProjectExplorer::Internal::buildAddFilesTree(session.root.get(), files,
+                                                                 nullptr, &selector));
+        QVERIFY(tree);
+        QVERIFY(selector.bestChoice());
+        QCOMPARE(selector.bestChoice()->node(), session.lastProject);
+    }
+}
+
+void tst_ProjectTree::buildAddProjectTree_data()
+{
+    addSessionRows();
+}
+
+void tst_ProjectTree::buildAddProjectTree()
+{
+    QFETCH(int, folderCount);
+    QFETCH(int, fileCount);
+
+    const Session session = createSession(folderCount);
+    const QStringList files = createFiles(session, fileCount);
+    const QString commonDirectory = FileName::fromString(files.first()).parentDir().toString();
+
+    QBENCHMARK {
+        BestNodeSelector selector(commonDirectory, files);
+        std::unique_ptr<AddNewTree> tree(
+                    ProjectExplorer::Internal::buildAddProjectTree(session.root.get(), files.first(),
+                                                                   nullptr, &selector));
+        QVERIFY(tree);
+        QCOMPARE(selector.bestChoice()->node(), session.lastProject);
+    }
+}
+
+void tst_ProjectTree::bestNodeSelector_data()
+{
+    addSessionRows();
+}
+
+// Only the selection, on a tree that was built before, as the page does for projects
+// whose subtree did not change.
+void tst_ProjectTree::bestNodeSelector()
+{
+    QFETCH(int, folderCount);
+    QFETCH(int, fileCount);
+
+    const Session session = createSession(folderCount);
+    const QStringList files = createFiles(session, fileCount);
+    const QString commonDirectory = FileName::fromString(files.first()).parentDir().toString();
+
+    BestNodeSelector builder(commonDirectory, files);
+    std::unique_ptr<AddNewTree> tree(
+                ProjectExplorer::Internal::buildAddFilesTree(session.root.get(), files, nullptr,
+                                                             &builder));
+    QVERIFY(tree);
+
+    QBENCHMARK {
+        BestNodeSelector selector(commonDirectory, files);
+        inspectAddNewTree(tree.get(), nullptr, &selector);
+        QCOMPARE(selector.bestChoice(), builder.bestChoice());
+    }
+}
+
+QTEST_MAIN(tst_ProjectTree)
+
+#include "tst_projecttree.moc"
@@ -0,0 +1,17 @@
+# Common setup of the tests that run without Qt Creator. They build against the same
+# Qt Creator as the plugin, see plugin-src/milo.pro for how to point them to it.
+
+isEmpty(IDE_SOURCE_TREE): IDE_SOURCE_TREE = $$(QTC_SOURCE)
+isEmpty(IDE_SOURCE_TREE): IDE_SOURCE_TREE = "$$PWD/../dependencies/src/qt-creator"
+
+isEmpty(IDE_BUILD_TREE): IDE_BUILD_TREE = $$(QTC_BUILD)
+isEmpty(IDE_BUILD_TREE): IDE_BUILD_TREE = "$$PWD/../dependencies/build/QtCreator"
+
+MILO_SOURCE_TREE = $$PWD/../plugin-src
+
+INCLUDEPATH += $$MILO_SOURCE_TREE \
+    $$MILO_SOURCE_TREE/external/projectexplorer \
+    $$MILO_SOURCE_TREE/external/projectexplorer/jsonwizard \
+    $$MILO_SOURCE_TREE/external/git
+
+include($$IDE_SOURCE_TREE/tests/auto/qttest.pri)